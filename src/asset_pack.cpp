@@ -0,0 +1,154 @@
+#include "asset_pack.hpp"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using eng::AssetPack;
+using eng::AssetView;
+
+AssetPack::AssetPack(const std::string& filePath)
+{
+#ifdef _WIN32
+    const HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        std::cout << "No asset pack at " << filePath << ", loading loose files" << std::endl;
+        return;
+    }
+    fileHandle = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        throw std::runtime_error("Failed to get asset pack size: " + filePath);
+    }
+    mappingSize = static_cast<size_t>(fileSize.QuadPart);
+
+    if (mappingSize > 0)
+    {
+        mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mappingHandle)
+        {
+            throw std::runtime_error("Failed to map asset pack: " + filePath);
+        }
+        mapping = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    }
+#else
+    const int file = open(filePath.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        std::cout << "No asset pack at " << filePath << ", loading loose files" << std::endl;
+        return;
+    }
+
+    struct stat fileStat;
+    if (fstat(file, &fileStat) != 0)
+    {
+        close(file);
+        throw std::runtime_error("Failed to get asset pack size: " + filePath);
+    }
+    mappingSize = static_cast<size_t>(fileStat.st_size);
+
+    if (mappingSize > 0)
+    {
+        void* address = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, file, 0);
+        mapping = address == MAP_FAILED ? nullptr : static_cast<const char*>(address);
+    }
+    // the mapping keeps the file referenced
+    close(file);
+#endif
+
+    if (!mapping)
+    {
+        throw std::runtime_error("Failed to map asset pack: " + filePath);
+    }
+
+    if (mappingSize < sizeof(AssetPackHeader))
+    {
+        throw std::runtime_error("Asset pack is truncated: " + filePath);
+    }
+
+    const auto header = reinterpret_cast<const AssetPackHeader*>(mapping);
+    if (header->magic != ASSET_PACK_MAGIC || header->version != ASSET_PACK_VERSION)
+    {
+        throw std::runtime_error("Asset pack has an unsupported header: " + filePath);
+    }
+    if (header->entryCount > (mappingSize - sizeof(AssetPackHeader)) / sizeof(AssetPackEntry))
+    {
+        throw std::runtime_error("Asset pack index is truncated: " + filePath);
+    }
+
+    entries = reinterpret_cast<const AssetPackEntry*>(mapping + sizeof(AssetPackHeader));
+    entryCount = header->entryCount;
+
+    for (uint64_t i = 0; i < entryCount; ++i)
+    {
+        if (entries[i].offset > mappingSize || entries[i].size > mappingSize - entries[i].offset)
+        {
+            throw std::runtime_error("Asset pack has an entry out of bounds: " + filePath);
+        }
+        if (i > 0 && entries[i - 1].pathHash >= entries[i].pathHash)
+        {
+            throw std::runtime_error("Asset pack index is not sorted: " + filePath);
+        }
+    }
+
+#ifndef _WIN32
+    // assets are read once while loading, let the kernel read ahead
+    madvise(const_cast<char*>(mapping), mappingSize, MADV_WILLNEED);
+#endif
+
+    std::cout << "Mapped asset pack " << filePath << " with " << entryCount << " entries" << std::endl;
+}
+
+AssetPack::~AssetPack()
+{
+#ifdef _WIN32
+    if (mapping)
+    {
+        UnmapViewOfFile(mapping);
+    }
+    if (mappingHandle)
+    {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle)
+    {
+        CloseHandle(fileHandle);
+    }
+#else
+    if (mapping)
+    {
+        munmap(const_cast<char*>(mapping), mappingSize);
+    }
+#endif
+}
+
+std::optional<AssetView> AssetPack::find(const std::string_view path) const
+{
+    const uint64_t pathHash = hashAssetPath(path);
+    const AssetPackEntry* end = entries + entryCount;
+    const AssetPackEntry* entry = std::lower_bound(entries, end, pathHash,
+            [](const AssetPackEntry& e, const uint64_t hash) { return e.pathHash < hash; });
+
+    if (entry == end || entry->pathHash != pathHash)
+    {
+        return std::nullopt;
+    }
+
+    return AssetView {
+        .format = entry->format,
+        .data = mapping + entry->offset,
+        .size = static_cast<size_t>(entry->size),
+    };
+}
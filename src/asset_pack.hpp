@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Archive written by asset_packer: an AssetPackHeader, entryCount AssetPackEntry records sorted by path hash,
+// then the asset data. Entry offsets are from the start of the file and aligned to ASSET_PACK_ALIGNMENT.
+namespace eng
+{
+    constexpr uint32_t ASSET_PACK_MAGIC = 0x4b50444c; // "LDPK"
+    constexpr uint32_t ASSET_PACK_VERSION = 1;
+    constexpr uint64_t ASSET_PACK_ALIGNMENT = 16;
+
+    enum class AssetFormat : uint32_t
+    {
+        Raw = 0,
+        BakedTexture = 1,
+        Wav = 2,
+    };
+
+    struct AssetPackHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t entryCount;
+    };
+
+    struct AssetPackEntry
+    {
+        uint64_t pathHash;
+        uint64_t offset;
+        uint64_t size;
+        AssetFormat format;
+        uint32_t reserved;
+    };
+
+    struct AssetView
+    {
+        AssetFormat format;
+        const char* data;
+        size_t size;
+    };
+
+    // FNV-1a of the path the asset would be loaded from as a loose file, e.g. "resources/audio/shotfx.wav"
+    constexpr uint64_t hashAssetPath(const std::string_view path)
+    {
+        uint64_t hash = 0xcbf29ce484222325;
+        for (const char c : path)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 0x100000001b3;
+        }
+        return hash;
+    }
+
+    // Read-only memory mapping of an asset pack. A missing pack is not an error, find() then returns nothing
+    // and callers load loose files instead.
+    struct AssetPack
+    {
+        explicit AssetPack(const std::string& filePath);
+        ~AssetPack();
+
+        AssetPack(const AssetPack&) = delete;
+        AssetPack(AssetPack&&) = delete;
+        AssetPack& operator=(const AssetPack&) = delete;
+        AssetPack& operator=(AssetPack&&) = delete;
+
+        // the returned data stays valid for the lifetime of the pack
+        std::optional<AssetView> find(const std::string_view path) const;
+
+        const char* mapping = nullptr;
+        size_t mappingSize = 0;
+        const AssetPackEntry* entries = nullptr;
+        uint64_t entryCount = 0;
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#endif
+    };
+}
@@ -0,0 +1,141 @@
+#include "asset_pack.hpp"
+#include "baked_texture.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+using namespace eng;
+
+struct PackedAsset
+{
+    AssetPackEntry entry;
+    std::string_view key;
+    std::vector<char> data;
+};
+
+static AssetFormat detectFormat(const std::vector<char>& data)
+{
+    if (data.size() >= sizeof(uint32_t))
+    {
+        uint32_t magic;
+        std::memcpy(&magic, data.data(), sizeof(magic));
+        if (magic == BAKED_TEXTURE_MAGIC)
+        {
+            return AssetFormat::BakedTexture;
+        }
+        if (std::memcmp(data.data(), "RIFF", 4) == 0)
+        {
+            return AssetFormat::Wav;
+        }
+    }
+    return AssetFormat::Raw;
+}
+
+int main(int argc, char** argv)
+{
+    std::string_view outputPath;
+    std::vector<std::string_view> keys;
+    std::vector<std::string_view> files;
+    std::vector<std::string_view>* list = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view argument = argv[i];
+        if (argument == "-o" && i + 1 < argc)
+        {
+            outputPath = argv[++i];
+        }
+        else if (argument == "--keys")
+        {
+            list = &keys;
+        }
+        else if (argument == "--files")
+        {
+            list = &files;
+        }
+        else if (list)
+        {
+            list->push_back(argument);
+        }
+        else
+        {
+            list = nullptr;
+            break;
+        }
+    }
+
+    if (outputPath.empty() || keys.size() != files.size() || !list)
+    {
+        std::cerr << "Usage: " << argv[0] << " -o <output> --keys <asset path>... --files <file>..." << std::endl;
+        return 1;
+    }
+
+    std::vector<PackedAsset> assets;
+    assets.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        std::ifstream input(files[i].data(), std::ios::binary);
+        if (!input)
+        {
+            std::cerr << "Failed to open " << files[i] << std::endl;
+            return 1;
+        }
+
+        PackedAsset& asset = assets.emplace_back(PackedAsset {
+                .entry = {},
+                .key = keys[i],
+                .data = std::vector<char>(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()),
+            });
+        asset.entry.pathHash = hashAssetPath(keys[i]);
+        asset.entry.size = asset.data.size();
+        asset.entry.format = detectFormat(asset.data);
+    }
+
+    std::sort(assets.begin(), assets.end(), [](const auto& a, const auto& b) { return a.entry.pathHash < b.entry.pathHash; });
+    for (size_t i = 1; i < assets.size(); ++i)
+    {
+        if (assets[i - 1].entry.pathHash == assets[i].entry.pathHash)
+        {
+            std::cerr << "Asset paths collide: " << assets[i - 1].key << ", " << assets[i].key << std::endl;
+            return 1;
+        }
+    }
+
+    const auto alignOffset = [](const uint64_t offset) { return (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT; };
+
+    uint64_t offset = alignOffset(sizeof(AssetPackHeader) + assets.size() * sizeof(AssetPackEntry));
+    std::vector<AssetPackEntry> entries;
+    entries.reserve(assets.size());
+    for (auto& asset : assets)
+    {
+        asset.entry.offset = offset;
+        entries.push_back(asset.entry);
+        offset = alignOffset(offset + asset.entry.size);
+    }
+
+    const AssetPackHeader header {
+        .magic = ASSET_PACK_MAGIC,
+        .version = ASSET_PACK_VERSION,
+        .entryCount = entries.size(),
+    };
+
+    std::ofstream output(outputPath.data(), std::ios::binary);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(AssetPackEntry));
+    for (const auto& asset : assets)
+    {
+        const std::vector<char> padding(asset.entry.offset - static_cast<uint64_t>(output.tellp()), 0);
+        output.write(padding.data(), padding.size());
+        output.write(asset.data.data(), asset.data.size());
+    }
+    if (!output)
+    {
+        std::cerr << "Failed to write " << outputPath << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
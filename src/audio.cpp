@@ -0,0 +1,754 @@
+#include "audio.hpp"
+#include "asset_pack.hpp"
+
+#include <SDL3/SDL_iostream.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numbers>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+#include <xmmintrin.h>
+#define AUDIO_MIX_SSE
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define AUDIO_MIX_NEON
+#endif
+
+using eng::Audio;
+
+// output[i] += gain * input[i]
+static void mixSamples(float* output, const float* input, const uint32_t count, const float gain)
+{
+    uint32_t i = 0;
+#if defined(AUDIO_MIX_SSE)
+    const __m128 gain4 = _mm_set1_ps(gain);
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_ps(output + i, _mm_add_ps(_mm_loadu_ps(output + i), _mm_mul_ps(_mm_loadu_ps(input + i), gain4)));
+    }
+#elif defined(AUDIO_MIX_NEON)
+    const float32x4_t gain4 = vdupq_n_f32(gain);
+    for (; i + 4 <= count; i += 4)
+    {
+        vst1q_f32(output + i, vmlaq_f32(vld1q_f32(output + i), vld1q_f32(input + i), gain4));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        output[i] += gain * input[i];
+    }
+}
+
+// interleaved stereo, output[2i] += leftGain * input[2i] and output[2i + 1] += rightGain * input[2i + 1]
+static void mixSamplesStereo(float* output, const float* input, const uint32_t count, const float leftGain, const float rightGain)
+{
+    uint32_t i = 0;
+#if defined(AUDIO_MIX_SSE)
+    const __m128 gain4 = _mm_setr_ps(leftGain, rightGain, leftGain, rightGain);
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_ps(output + i, _mm_add_ps(_mm_loadu_ps(output + i), _mm_mul_ps(_mm_loadu_ps(input + i), gain4)));
+    }
+#elif defined(AUDIO_MIX_NEON)
+    const float gains[] = { leftGain, rightGain, leftGain, rightGain };
+    const float32x4_t gain4 = vld1q_f32(gains);
+    for (; i + 4 <= count; i += 4)
+    {
+        vst1q_f32(output + i, vmlaq_f32(vld1q_f32(output + i), vld1q_f32(input + i), gain4));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        output[i] += (i % 2 == 0 ? leftGain : rightGain) * input[i];
+    }
+}
+
+// inverse distance rolloff, faded out over the last quarter of the audible range so sounds don't cut off
+static float getDistanceGain(const float distance)
+{
+    const float rolloff = Audio::REFERENCE_DISTANCE / std::max(distance, Audio::REFERENCE_DISTANCE);
+    const float fade = (Audio::MAX_AUDIBLE_DISTANCE - distance) / (0.25f * Audio::MAX_AUDIBLE_DISTANCE);
+    return rolloff * std::clamp(fade, 0.0f, 1.0f);
+}
+
+// applies the master gain and keeps the sum of many voices from wrapping when the device format is integer
+static void finishSamples(float* samples, const uint32_t count, const float gain)
+{
+    uint32_t i = 0;
+#if defined(AUDIO_MIX_SSE)
+    const __m128 gain4 = _mm_set1_ps(gain);
+    const __m128 min4 = _mm_set1_ps(-1.0f);
+    const __m128 max4 = _mm_set1_ps(1.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_ps(samples + i, _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(samples + i), gain4), min4), max4));
+    }
+#elif defined(AUDIO_MIX_NEON)
+    const float32x4_t min4 = vdupq_n_f32(-1.0f);
+    const float32x4_t max4 = vdupq_n_f32(1.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        vst1q_f32(samples + i, vminq_f32(vmaxq_f32(vmulq_n_f32(vld1q_f32(samples + i), gain), min4), max4));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        samples[i] = std::clamp(samples[i] * gain, -1.0f, 1.0f);
+    }
+}
+
+// canonical 44 byte header for 32 bit float samples, rewritten with the final size when the sink closes
+static bool writeWavHeader(SDL_IOStream* io, const SDL_AudioSpec& spec, const uint32_t dataSize)
+{
+    const uint16_t blockAlign = spec.channels * sizeof(float);
+    return SDL_WriteIO(io, "RIFF", 4) == 4
+        && SDL_WriteU32LE(io, 36 + dataSize)
+        && SDL_WriteIO(io, "WAVEfmt ", 8) == 8
+        && SDL_WriteU32LE(io, 16)
+        && SDL_WriteU16LE(io, 3)
+        && SDL_WriteU16LE(io, spec.channels)
+        && SDL_WriteU32LE(io, spec.freq)
+        && SDL_WriteU32LE(io, spec.freq * blockAlign)
+        && SDL_WriteU16LE(io, blockAlign)
+        && SDL_WriteU16LE(io, 32)
+        && SDL_WriteIO(io, "data", 4) == 4
+        && SDL_WriteU32LE(io, dataSize);
+}
+
+Audio::Audio(const AssetPack& assetPack, const char* sinkPath) :
+    assetPack(assetPack),
+    commands(COMMAND_QUEUE_SIZE),
+    streamRequests(COMMAND_QUEUE_SIZE),
+    streamCommands(COMMAND_QUEUE_SIZE),
+    releasedStreams(COMMAND_QUEUE_SIZE)
+{
+    const bool useDevice = !sinkPath && SDL_GetAudioDeviceFormat(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &mixSpec, nullptr);
+    if (!useDevice)
+    {
+        mixSpec.freq = HEADLESS_FREQUENCY;
+        mixSpec.channels = HEADLESS_CHANNELS;
+    }
+    mixSpec.format = SDL_AUDIO_F32;
+
+    // allocated up front, the callback never allocates
+    mixBuffer.resize(MIX_BUFFER_FRAMES * mixSpec.channels);
+    streamBuffer.resize(MIX_BUFFER_FRAMES * mixSpec.channels);
+
+    running = true;
+    streamThread = std::thread(&Audio::streamMusic, this);
+
+    if (useDevice)
+    {
+        stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &mixSpec, &Audio::audioCallback, this);
+        if (!stream || !SDL_ResumeAudioStreamDevice(stream))
+        {
+            std::cerr << "failed to open audio playback device, mixing headless: " << SDL_GetError() << std::endl;
+            SDL_DestroyAudioStream(stream);
+            stream = nullptr;
+        }
+    }
+
+    if (!stream)
+    {
+        openSink(sinkPath);
+    }
+}
+
+Audio::~Audio()
+{
+    // also closes the device, the callback is not called after this returns
+    SDL_DestroyAudioStream(stream);
+
+    running = false;
+    streamThread.join();
+
+    if (sinkFile)
+    {
+        // RIFF sizes are 32 bit, longer recordings keep playing but report the wrong length
+        const uint32_t dataSize = std::min<uint64_t>(sinkDataSize, UINT32_MAX - 36);
+        if (SDL_SeekIO(sinkFile, 0, SDL_IO_SEEK_SET) < 0 || !writeWavHeader(sinkFile, mixSpec, dataSize))
+        {
+            std::cerr << "failed to finish audio sink file: " << SDL_GetError() << std::endl;
+        }
+        SDL_CloseIO(sinkFile);
+    }
+}
+
+void Audio::openSink(const char* sinkPath)
+{
+    if (sinkPath && std::string_view(sinkPath) != "null")
+    {
+        sinkFile = SDL_IOFromFile(sinkPath, "wb");
+        if (!sinkFile || !writeWavHeader(sinkFile, mixSpec, 0))
+        {
+            const std::string error = SDL_GetError();
+            SDL_CloseIO(sinkFile);
+            running = false;
+            streamThread.join();
+            throw std::runtime_error((std::stringstream{} << "failed to open audio sink file: " << sinkPath << ": " << error).str());
+        }
+    }
+
+}
+
+void Audio::advance(const double seconds)
+{
+    if (stream)
+    {
+        return;
+    }
+
+    headlessTime += seconds;
+    const uint64_t targetFrames = static_cast<uint64_t>(headlessTime * mixSpec.freq);
+    while (renderedFrames < targetFrames)
+    {
+        const uint32_t frameCount = static_cast<uint32_t>(std::min<uint64_t>(targetFrames - renderedFrames, MIX_BUFFER_FRAMES));
+        renderFrames(mixBuffer.data(), frameCount);
+        if (sinkFile)
+        {
+            sinkDataSize += SDL_WriteIO(sinkFile, mixBuffer.data(), frameCount * mixSpec.channels * sizeof(float));
+        }
+    }
+}
+
+Audio::MusicStream::MusicStream(SDL_IOStream* io, const SDL_AudioSpec& mixSpec) :
+    io(io, &SDL_CloseIO),
+    info(readWavInfo(io)),
+    converter(SDL_CreateAudioStream(&info.spec, &mixSpec), &SDL_DestroyAudioStream),
+    samples(static_cast<size_t>(STREAM_BUFFER_SECONDS * mixSpec.freq) * mixSpec.channels)
+{
+    if (!converter)
+    {
+        throw std::runtime_error((std::stringstream{} << "failed to create audio stream: " << SDL_GetError()).str());
+    }
+
+    if (SDL_SeekIO(io, info.dataOffset, SDL_IO_SEEK_SET) < 0)
+    {
+        throw std::runtime_error((std::stringstream{} << "failed to seek audio stream: " << SDL_GetError()).str());
+    }
+}
+
+// reads the next block of source frames into the converter, jumping back to the loop start at the loop end
+bool Audio::MusicStream::readChunk()
+{
+    if (position >= info.loopEnd)
+    {
+        if (SDL_SeekIO(io.get(), info.dataOffset + info.loopStart, SDL_IO_SEEK_SET) < 0)
+        {
+            return false;
+        }
+        position = info.loopStart;
+    }
+
+    uint8_t chunk[STREAM_READ_BYTES];
+    const size_t size = std::min<uint64_t>(sizeof(chunk) / info.frameSize * info.frameSize, info.loopEnd - position);
+    const size_t read = SDL_ReadIO(io.get(), chunk, size);
+    if (read == 0)
+    {
+        return false;
+    }
+
+    position += read;
+    return SDL_PutAudioStreamData(converter.get(), chunk, read);
+}
+
+void Audio::MusicStream::fill()
+{
+    float buffer[4096];
+    while (samples.writeAvailable() >= std::size(buffer))
+    {
+        if (SDL_GetAudioStreamAvailable(converter.get()) < static_cast<int>(sizeof(buffer)))
+        {
+            if (!readChunk())
+            {
+                return;
+            }
+            continue;
+        }
+
+        const int bytes = SDL_GetAudioStreamData(converter.get(), buffer, sizeof(buffer));
+        if (bytes <= 0)
+        {
+            return;
+        }
+        samples.write(buffer, bytes / sizeof(float));
+    }
+}
+
+void Audio::startStream(const StreamRequest& request)
+{
+    // streams read straight out of the asset pack mapping when the file is packed
+    const auto asset = assetPack.find(request.filePath);
+    SDL_IOStream* io = asset && asset->format == AssetFormat::Wav
+        ? SDL_IOFromConstMem(asset->data, asset->size)
+        : SDL_IOFromFile(request.filePath, "rb");
+    if (!io)
+    {
+        std::cerr << "failed to open audio from path: " << request.filePath << ": " << SDL_GetError() << std::endl;
+        return;
+    }
+
+    try
+    {
+        auto& musicStream = musicStreams.emplace_back(std::make_unique<MusicStream>(io, mixSpec));
+        // prime the buffer so the loop doesn't start with an underrun
+        musicStream->fill();
+        streamCommands.push(Command {
+                .type = Command::Type::PlayStream,
+                .handle = request.handle,
+                .stream = musicStream.get(),
+                .value = request.fadeSeconds,
+            });
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "failed to stream audio from path: " << request.filePath << ": " << e.what() << std::endl;
+    }
+}
+
+void Audio::streamMusic()
+{
+    while (running)
+    {
+        MusicStream* released;
+        while (releasedStreams.pop(released))
+        {
+            std::erase_if(musicStreams, [&](const auto& musicStream) { return musicStream.get() == released; });
+        }
+
+        StreamRequest request;
+        while (streamRequests.pop(request))
+        {
+            if (request.filePath)
+            {
+                startStream(request);
+            }
+            else
+            {
+                // forwarded so the stop can't overtake the start of the same loop
+                streamCommands.push(Command {
+                        .type = Command::Type::Stop,
+                        .handle = request.handle,
+                        .value = request.fadeSeconds,
+                    });
+            }
+        }
+
+        for (const auto& musicStream : musicStreams)
+        {
+            musicStream->fill();
+        }
+
+        // well inside the ring buffer length
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+uint32_t Audio::loadSound(const std::string& filePath, const int32_t priority)
+{
+    if (const auto it = soundIndices.find(filePath); it != soundIndices.end())
+    {
+        return it->second;
+    }
+
+    SDL_AudioSpec audioSpec;
+    uint8_t* pcm;
+    uint32_t length;
+    const auto asset = assetPack.find(filePath);
+    const bool loaded = asset && asset->format == AssetFormat::Wav
+        ? SDL_LoadWAV_IO(SDL_IOFromConstMem(asset->data, asset->size), true, &audioSpec, &pcm, &length)
+        : SDL_LoadWAV(filePath.c_str(), &audioSpec, &pcm, &length);
+    if (!loaded)
+    {
+        throw std::runtime_error((std::stringstream{} << "failed to load audio from path: " << filePath << ": " << SDL_GetError()).str());
+    }
+
+    uint8_t* converted;
+    int convertedLength;
+    const bool convertedOk = SDL_ConvertAudioSamples(&audioSpec, pcm, length, &mixSpec, &converted, &convertedLength);
+    SDL_free(pcm);
+    if (!convertedOk)
+    {
+        throw std::runtime_error((std::stringstream{} << "failed to convert audio from path: " << filePath << ": " << SDL_GetError()).str());
+    }
+
+    // voices point at the sample data, which stays put when the sound list grows
+    const uint32_t index = sounds.size();
+    sounds.push_back(Sound {
+            .samples = std::vector<float>(reinterpret_cast<const float*>(converted), reinterpret_cast<const float*>(converted + convertedLength)),
+            .priority = priority,
+        });
+    SDL_free(converted);
+
+    soundIndices.emplace(filePath, index);
+    return index;
+}
+
+void Audio::audioCallback(void* userdata, SDL_AudioStream* stream, int additionalAmount, int)
+{
+    Audio& audio = *static_cast<Audio*>(userdata);
+    const uint32_t frameSize = sizeof(float) * audio.mixSpec.channels;
+    uint32_t remainingFrames = (additionalAmount + frameSize - 1) / frameSize;
+    while (remainingFrames > 0)
+    {
+        const uint32_t frameCount = std::min(remainingFrames, MIX_BUFFER_FRAMES);
+        audio.renderFrames(audio.mixBuffer.data(), frameCount);
+        SDL_PutAudioStreamData(stream, audio.mixBuffer.data(), frameCount * frameSize);
+        remainingFrames -= frameCount;
+    }
+}
+
+void Audio::renderFrames(float* output, const uint32_t frameCount)
+{
+    Command command;
+    while (streamCommands.pop(command) || commands.pop(command))
+    {
+        processCommand(command);
+    }
+
+    // the stream scratch buffer holds one mix buffer
+    for (uint32_t frame = 0; frame < frameCount; frame += MIX_BUFFER_FRAMES)
+    {
+        const uint32_t chunkFrames = std::min(frameCount - frame, MIX_BUFFER_FRAMES);
+        mix(output + frame * mixSpec.channels, chunkFrames * mixSpec.channels);
+    }
+    renderedFrames += frameCount;
+}
+
+void Audio::processCommand(const Command& command)
+{
+    switch (command.type)
+    {
+        case Command::Type::PlaySound:
+            startVoice(Voice {
+                    .samples = command.samples,
+                    .sampleCount = command.sampleCount,
+                    .priority = command.priority,
+                    .handle = command.handle,
+                    .positional = command.positional,
+                    .worldPosition = command.position,
+                    .active = true,
+                });
+            break;
+        case Command::Type::PlayStream:
+            startVoice(Voice {
+                    .stream = command.stream,
+                    .priority = LOOP_PRIORITY,
+                    .handle = command.handle,
+                    .gain = command.value > 0.0f ? 0.0f : 1.0f,
+                    .targetGain = 1.0f,
+                    .gainStep = command.value > 0.0f ? getGainStep(0.0f, 1.0f, command.value) : 0.0f,
+                    .active = true,
+                });
+            break;
+        case Command::Type::Stop:
+        case Command::Type::SetGain:
+            for (auto& voice : voices)
+            {
+                if (!voice.active || voice.handle != command.handle)
+                {
+                    continue;
+                }
+                if (command.type == Command::Type::SetGain)
+                {
+                    voice.gain = command.value;
+                    voice.targetGain = command.value;
+                    voice.gainStep = 0.0f;
+                }
+                else if (command.value > 0.0f && voice.gain > 0.0f)
+                {
+                    voice.targetGain = 0.0f;
+                    voice.gainStep = getGainStep(voice.gain, 0.0f, command.value);
+                    voice.stopAfterFade = true;
+                }
+                else
+                {
+                    stopVoice(voice);
+                }
+            }
+            break;
+        case Command::Type::SetMasterGain:
+            masterGain = command.value;
+            break;
+        case Command::Type::SetListener:
+            mixListener = Listener {
+                .position = command.position,
+                .right = command.direction,
+            };
+            break;
+    }
+}
+
+void Audio::mix(float* output, const uint32_t sampleCount)
+{
+    std::fill_n(output, sampleCount, 0.0f);
+
+    for (auto& voice : voices)
+    {
+        // positional gains are worked out once per callback, sources don't move far in a few milliseconds
+        float leftGain = 1.0f;
+        float rightGain = 1.0f;
+        if (voice.active && voice.positional)
+        {
+            const glm::vec3 offset = voice.worldPosition - mixListener.position;
+            const float distance = glm::length(offset);
+            const float distanceGain = getDistanceGain(distance);
+            if (distanceGain == 0.0f)
+            {
+                // out of range, skipped without mixing but keeps playing in case the listener comes back
+                voice.position = std::min(voice.position + sampleCount, voice.sampleCount);
+                if (voice.position == voice.sampleCount)
+                {
+                    stopVoice(voice);
+                }
+                continue;
+            }
+
+            // equal power pan, scaled so a centered sound plays at the distance gain
+            const float pan = distance > 0.0f ? glm::dot(offset, mixListener.right) / distance : 0.0f;
+            const float angle = (pan + 1.0f) * 0.25f * std::numbers::pi_v<float>;
+            leftGain = distanceGain * std::numbers::sqrt2_v<float> * std::cos(angle);
+            rightGain = distanceGain * std::numbers::sqrt2_v<float> * std::sin(angle);
+            if (mixSpec.channels != 2)
+            {
+                leftGain = rightGain = distanceGain;
+            }
+        }
+
+        uint32_t mixed = 0;
+        while (voice.active && mixed < sampleCount)
+        {
+            uint32_t count = sampleCount - mixed;
+            if (voice.gainStep != 0.0f)
+            {
+                count = std::min(count, RAMP_BLOCK_FRAMES * mixSpec.channels);
+            }
+
+            const float* input;
+            if (voice.stream)
+            {
+                // on underrun the voice resumes once the streaming thread catches up
+                count = voice.stream->samples.read(streamBuffer.data(), count);
+                if (count == 0)
+                {
+                    break;
+                }
+                input = streamBuffer.data();
+            }
+            else
+            {
+                count = std::min(count, voice.sampleCount - voice.position);
+                input = voice.samples + voice.position;
+                voice.position += count;
+            }
+
+            if (leftGain != rightGain)
+            {
+                mixSamplesStereo(output + mixed, input, count, voice.gain * leftGain, voice.gain * rightGain);
+            }
+            else
+            {
+                mixSamples(output + mixed, input, count, voice.gain * leftGain);
+            }
+            mixed += count;
+
+            if (voice.gainStep != 0.0f)
+            {
+                voice.gain += voice.gainStep * count;
+                if ((voice.gainStep > 0.0f) == (voice.gain >= voice.targetGain))
+                {
+                    voice.gain = voice.targetGain;
+                    voice.gainStep = 0.0f;
+                    if (voice.stopAfterFade)
+                    {
+                        stopVoice(voice);
+                    }
+                }
+            }
+
+            if (!voice.stream && voice.position == voice.sampleCount)
+            {
+                stopVoice(voice);
+            }
+        }
+    }
+
+    finishSamples(output, sampleCount, masterGain);
+}
+
+void Audio::startVoice(const Voice& voice)
+{
+    // prefer a free voice, then the lowest priority one, then whichever of those is closest to finishing
+    uint32_t index = MAX_VOICES;
+    for (uint32_t i = 0; i < MAX_VOICES; ++i)
+    {
+        const Voice& other = voices[i];
+        if (!other.active)
+        {
+            index = i;
+            break;
+        }
+        if (other.priority > voice.priority || other.stream)
+        {
+            continue;
+        }
+        if (index == MAX_VOICES
+                || other.priority < voices[index].priority
+                || (other.priority == voices[index].priority && other.sampleCount - other.position < voices[index].sampleCount - voices[index].position))
+        {
+            index = i;
+        }
+    }
+
+    if (index < MAX_VOICES)
+    {
+        voices[index] = voice;
+    }
+    else if (voice.stream)
+    {
+        releasedStreams.push(voice.stream);
+    }
+}
+
+void Audio::stopVoice(Voice& voice)
+{
+    if (voice.stream)
+    {
+        // the streaming thread frees it
+        releasedStreams.push(voice.stream);
+    }
+    voice = Voice{};
+}
+
+float Audio::getGainStep(const float from, const float to, const float seconds) const
+{
+    return (to - from) / (seconds * mixSpec.freq * mixSpec.channels);
+}
+
+uint32_t Audio::createHandle()
+{
+    const uint32_t handle = nextHandle++;
+    if (nextHandle == INVALID_HANDLE)
+    {
+        nextHandle = 0;
+    }
+    return handle;
+}
+
+void Audio::pushCommand(const Command& command)
+{
+    // only fails if the callback has stalled for a whole queue's worth of commands, dropping is the best option
+    commands.push(command);
+}
+
+uint32_t Audio::createLoop(const std::string& filePath, const float fadeInSeconds)
+{
+    // the streaming thread opens the file, paths stay alive for it
+    auto it = std::find(loopPaths.begin(), loopPaths.end(), filePath);
+    const std::string& path = it != loopPaths.end() ? *it : loopPaths.emplace_back(filePath);
+
+    const uint32_t handle = createHandle();
+    streamRequests.push(StreamRequest {
+            .handle = handle,
+            .filePath = path.c_str(),
+            .fadeSeconds = fadeInSeconds,
+        });
+    return handle;
+}
+
+void Audio::destroyLoop(uint32_t index, const float fadeOutSeconds)
+{
+    streamRequests.push(StreamRequest {
+            .handle = index,
+            .filePath = nullptr,
+            .fadeSeconds = fadeOutSeconds,
+        });
+}
+
+uint32_t Audio::createSingleShot(const std::string& filePath)
+{
+    return createSingleShot(loadSound(filePath, 0));
+}
+
+uint32_t Audio::createSingleShot(const uint32_t sound)
+{
+    if (sound >= sounds.size() || sounds[sound].samples.empty())
+    {
+        return INVALID_HANDLE;
+    }
+
+    const uint32_t handle = createHandle();
+    pushCommand(Command {
+            .type = Command::Type::PlaySound,
+            .handle = handle,
+            .samples = sounds[sound].samples.data(),
+            .sampleCount = static_cast<uint32_t>(sounds[sound].samples.size()),
+            .priority = sounds[sound].priority,
+        });
+    return handle;
+}
+
+uint32_t Audio::createSingleShot(const uint32_t sound, const glm::vec3& position)
+{
+    // culled before it takes up a voice
+    if (sound >= sounds.size() || sounds[sound].samples.empty()
+            || glm::length(position - listener.position) >= MAX_AUDIBLE_DISTANCE)
+    {
+        return INVALID_HANDLE;
+    }
+
+    const uint32_t handle = createHandle();
+    pushCommand(Command {
+            .type = Command::Type::PlaySound,
+            .handle = handle,
+            .samples = sounds[sound].samples.data(),
+            .sampleCount = static_cast<uint32_t>(sounds[sound].samples.size()),
+            .priority = sounds[sound].priority,
+            .positional = true,
+            .position = position,
+        });
+    return handle;
+}
+
+void Audio::destroySingleShot(uint32_t index)
+{
+    pushCommand(Command {
+            .type = Command::Type::Stop,
+            .handle = index,
+        });
+}
+
+void Audio::setGain(uint32_t index, const float gain)
+{
+    pushCommand(Command {
+            .type = Command::Type::SetGain,
+            .handle = index,
+            .value = gain,
+        });
+}
+
+void Audio::setListener(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& up)
+{
+    listener = Listener {
+        .position = position,
+        .right = glm::normalize(glm::cross(forward, up)),
+    };
+    pushCommand(Command {
+            .type = Command::Type::SetListener,
+            .position = listener.position,
+            .direction = listener.right,
+        });
+}
+
+void Audio::setMuted(const bool value)
+{
+    pushCommand(Command {
+            .type = Command::Type::SetMasterGain,
+            .value = value ? 0.0f : 1.0f,
+        });
+}
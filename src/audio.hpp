@@ -0,0 +1,222 @@
+#pragma once
+
+#include "engine.hpp"
+#include "spsc_ring_buffer.hpp"
+#include "wav_reader.hpp"
+
+#include <SDL3/SDL_audio.h>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+
+namespace eng
+{
+    struct AssetPack;
+
+    // Mixes a fixed pool of voices into a single device stream from the SDL audio callback. When every voice
+    // is busy a new sound steals the lowest priority voice, or is dropped if all playing sounds outrank it.
+    // Loops are streamed: a background thread decodes them in chunks into small ring buffers the mixer reads.
+    //
+    // Game-side calls only push commands into lock-free queues and return a handle right away. The audio
+    // callback owns the voices, the streaming thread owns the music streams:
+    //   game -> callback: play, stop, set gain, master gain, listener
+    //   game -> streaming thread: start and stop loops (stops follow their start through the same queues)
+    //   streaming thread -> callback: loops ready to play, forwarded stops
+    //   callback -> streaming thread: streams no voice uses any more
+    //
+    // Without a playback device, or with a sink given, the mixer runs headless on a virtual clock: advance()
+    // mixes exactly as many frames as the time passed in, without waiting for real time, and the output is
+    // discarded or written to a WAV file. The sink is "null" to discard or the path of the WAV file to write,
+    // the engine takes it from LD57_AUDIO_SINK. renderFrames() mixes into memory for tests and benchmarks.
+    // Loops are still streamed in real time, a virtual clock running far ahead of it can underrun them.
+    class Audio final : public AudioInterface
+    {
+    public:
+        static constexpr uint32_t MAX_VOICES = 32;
+        static constexpr uint32_t MIX_BUFFER_FRAMES = 1024;
+        // gain ramps are applied in steps of this many frames
+        static constexpr uint32_t RAMP_BLOCK_FRAMES = 64;
+        static constexpr float STREAM_BUFFER_SECONDS = 0.5f;
+        static constexpr uint32_t STREAM_READ_BYTES = 16384;
+        static constexpr uint32_t COMMAND_QUEUE_SIZE = 256;
+        static constexpr int32_t LOOP_PRIORITY = INT32_MAX;
+        // positional sounds play at full volume up to the reference distance and are inaudible past the max
+        static constexpr float REFERENCE_DISTANCE = 2.0f;
+        static constexpr float MAX_AUDIBLE_DISTANCE = 24.0f;
+        // headless mix format when there's no device to ask
+        static constexpr int HEADLESS_FREQUENCY = 48000;
+        static constexpr int HEADLESS_CHANNELS = 2;
+        static constexpr uint32_t INVALID_HANDLE = UINT32_MAX;
+
+    private:
+        // decoded once and converted to float samples at the device rate and channel count
+        struct Sound
+        {
+            std::vector<float> samples;
+            int32_t priority;
+        };
+
+        // written by the streaming thread, read by the audio callback
+        struct MusicStream
+        {
+            const std::unique_ptr<SDL_IOStream, decltype(&SDL_CloseIO)> io;
+            const WavInfo info;
+            const std::unique_ptr<SDL_AudioStream, decltype(&SDL_DestroyAudioStream)> converter;
+            SpscRingBuffer<float> samples;
+            uint64_t position = 0;
+
+            explicit MusicStream(SDL_IOStream* io, const SDL_AudioSpec& mixSpec);
+
+            bool readChunk();
+            void fill();
+        };
+
+        struct Command
+        {
+            enum class Type
+            {
+                PlaySound,
+                PlayStream,
+                Stop,
+                SetGain,
+                SetMasterGain,
+                SetListener,
+            };
+
+            Type type = Type::Stop;
+            uint32_t handle = INVALID_HANDLE;
+            // PlaySound
+            const float* samples = nullptr;
+            uint32_t sampleCount = 0;
+            int32_t priority = 0;
+            // PlayStream
+            MusicStream* stream = nullptr;
+            // gain for SetGain and SetMasterGain, fade time for PlayStream and Stop
+            float value = 0.0f;
+            // PlaySound when positional, listener position and right axis for SetListener
+            bool positional = false;
+            glm::vec3 position = glm::vec3(0);
+            glm::vec3 direction = glm::vec3(0);
+        };
+
+        struct StreamRequest
+        {
+            uint32_t handle = INVALID_HANDLE;
+            // points into loopPaths, nullptr to stop the loop
+            const char* filePath = nullptr;
+            float fadeSeconds = 0.0f;
+        };
+
+        struct Voice
+        {
+            const float* samples = nullptr;
+            uint32_t sampleCount = 0;
+            uint32_t position = 0;
+            MusicStream* stream = nullptr;
+            int32_t priority = 0;
+            uint32_t handle = INVALID_HANDLE;
+            float gain = 1.0f;
+            float targetGain = 1.0f;
+            // per sample, zero when not fading
+            float gainStep = 0.0f;
+            bool stopAfterFade = false;
+            bool positional = false;
+            glm::vec3 worldPosition = glm::vec3(0);
+            bool active = false;
+        };
+
+        struct Listener
+        {
+            glm::vec3 position = glm::vec3(0);
+            glm::vec3 right = glm::vec3(1, 0, 0);
+        };
+
+        const AssetPack& assetPack;
+        SDL_AudioSpec mixSpec;
+
+        // game thread
+        std::vector<Sound> sounds;
+        std::unordered_map<std::string, uint32_t> soundIndices;
+        std::deque<std::string> loopPaths;
+        uint32_t nextHandle = 0;
+        Listener listener;
+
+        SpscRingBuffer<Command> commands;
+        SpscRingBuffer<StreamRequest> streamRequests;
+        SpscRingBuffer<Command> streamCommands;
+        SpscRingBuffer<MusicStream*> releasedStreams;
+
+        // audio callback
+        Voice voices[MAX_VOICES];
+        std::vector<float> mixBuffer;
+        std::vector<float> streamBuffer;
+        float masterGain = 1.0f;
+        Listener mixListener;
+
+        // streaming thread
+        std::vector<std::unique_ptr<MusicStream>> musicStreams;
+        std::atomic<bool> running;
+        std::thread streamThread;
+
+        // device output, or the headless clock and its optional WAV file
+        SDL_AudioStream* stream = nullptr;
+        double headlessTime = 0.0;
+        uint64_t renderedFrames = 0;
+        SDL_IOStream* sinkFile = nullptr;
+        uint64_t sinkDataSize = 0;
+
+        static void audioCallback(void* userdata, SDL_AudioStream* stream, int additionalAmount, int totalAmount);
+        void openSink(const char* sinkPath);
+        void processCommand(const Command& command);
+        void mix(float* output, const uint32_t sampleCount);
+        void startVoice(const Voice& voice);
+        void stopVoice(Voice& voice);
+        float getGainStep(const float from, const float to, const float seconds) const;
+
+        void streamMusic();
+        void startStream(const StreamRequest& request);
+
+        uint32_t createHandle();
+        void pushCommand(const Command& command);
+
+    public:
+        // sink is nullptr to play on the default device, falling back to headless without one
+        explicit Audio(const AssetPack& assetPack, const char* sink = nullptr);
+        ~Audio();
+
+        Audio(const Audio&) = delete;
+        Audio(Audio&&) = delete;
+        Audio& operator=(const Audio&) = delete;
+        Audio& operator=(Audio&&) = delete;
+
+        uint32_t loadSound(const std::string& filePath, const int32_t priority) override;
+        uint32_t createLoop(const std::string& filePath, const float fadeInSeconds) override;
+        void destroyLoop(uint32_t index, const float fadeOutSeconds) override;
+        uint32_t createSingleShot(const std::string& filePath) override;
+        uint32_t createSingleShot(const uint32_t sound) override;
+        uint32_t createSingleShot(const uint32_t sound, const glm::vec3& position) override;
+        void destroySingleShot(uint32_t index) override;
+        void setGain(uint32_t index, const float gain) override;
+        void setListener(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& up) override;
+        void setMuted(const bool value) override;
+
+        // headless only, moves the virtual clock forward and mixes the frames it passed into the sink
+        void advance(const double seconds);
+
+        // headless only, from the same thread as advance(). mixes the next frames into output, interleaved at
+        // the mix channel count, and moves the virtual clock past them
+        void renderFrames(float* output, const uint32_t frameCount);
+
+        bool isHeadless() const
+        {
+            return !stream;
+        }
+
+        const SDL_AudioSpec& getMixSpec() const
+        {
+            return mixSpec;
+        }
+    };
+}
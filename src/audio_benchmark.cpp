@@ -0,0 +1,65 @@
+#include "asset_pack.hpp"
+#include "audio.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using eng::Audio;
+
+// seconds of audio mixed on the headless virtual clock
+constexpr double MIXED_SECONDS = 60.0;
+
+// Keeps every voice busy, half of them positional so both the mono and the panned paths are mixed, and reports
+// how much faster than real time the mixer runs
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <sound.wav>" << std::endl;
+        return 1;
+    }
+
+    // no pack, the sound is loaded as a loose file
+    const eng::AssetPack assetPack("");
+    Audio audio(assetPack, "null");
+    const uint32_t sound = audio.loadSound(argv[1], 0);
+    audio.setListener(glm::vec3(0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0));
+
+    const SDL_AudioSpec& spec = audio.getMixSpec();
+    const uint64_t totalFrames = static_cast<uint64_t>(MIXED_SECONDS * spec.freq);
+    std::vector<float> output(Audio::MIX_BUFFER_FRAMES * spec.channels);
+    float checksum = 0.0f;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t frame = 0; frame < totalFrames; frame += Audio::MIX_BUFFER_FRAMES)
+    {
+        // retriggered every block so voices never run out, equal priority sounds steal the busy voices.
+        // the commands are a small part of the cost next to mixing a block per voice
+        for (uint32_t i = 0; i < Audio::MAX_VOICES; ++i)
+        {
+            if (i % 2 == 0)
+            {
+                audio.createSingleShot(sound);
+            }
+            else
+            {
+                audio.createSingleShot(sound, glm::vec3(static_cast<float>(i) - Audio::MAX_VOICES / 2.0f, 0, -2));
+            }
+        }
+
+        audio.renderFrames(output.data(), Audio::MIX_BUFFER_FRAMES);
+        checksum += output[frame % output.size()];
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const double framesPerSecond = totalFrames / seconds;
+    std::cout << Audio::MAX_VOICES << " voices, " << spec.channels << " channels at " << spec.freq << " Hz" << std::endl;
+    std::cout << "mixed " << totalFrames << " frames in " << seconds * 1000.0 << " ms" << std::endl;
+    std::cout << framesPerSecond << " frames/s, " << framesPerSecond * Audio::MAX_VOICES << " voice frames/s, "
+        << framesPerSecond / spec.freq << "x real time" << std::endl;
+    // keeps the mix from being optimized out
+    std::cout << "checksum " << checksum << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,312 @@
+#include "baked_texture.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+using eng::BakedTextureView;
+
+namespace
+{
+    struct Color
+    {
+        int32_t r, g, b;
+    };
+
+    uint16_t packColor565(const float r, const float g, const float b)
+    {
+        const auto quantize = [](const float value, const int32_t maxValue)
+        {
+            return static_cast<uint16_t>(std::clamp(static_cast<int32_t>(value / 255.0f * maxValue + 0.5f), 0, maxValue));
+        };
+        return (quantize(r, 31) << 11) | (quantize(g, 63) << 5) | quantize(b, 31);
+    }
+
+    Color unpackColor565(const uint16_t color)
+    {
+        const int32_t r = (color >> 11) & 31;
+        const int32_t g = (color >> 5) & 63;
+        const int32_t b = color & 31;
+        return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+    }
+
+    // palette entry 3 is transparent black when the block is in 3-color mode (color0 <= color1)
+    void getPalette(const uint16_t color0, const uint16_t color1, Color palette[4])
+    {
+        palette[0] = unpackColor565(color0);
+        palette[1] = unpackColor565(color1);
+        if (color0 > color1)
+        {
+            palette[2] = {
+                (2 * palette[0].r + palette[1].r) / 3,
+                (2 * palette[0].g + palette[1].g) / 3,
+                (2 * palette[0].b + palette[1].b) / 3,
+            };
+            palette[3] = {
+                (palette[0].r + 2 * palette[1].r) / 3,
+                (palette[0].g + 2 * palette[1].g) / 3,
+                (palette[0].b + 2 * palette[1].b) / 3,
+            };
+        }
+        else
+        {
+            palette[2] = {
+                (palette[0].r + palette[1].r) / 2,
+                (palette[0].g + palette[1].g) / 2,
+                (palette[0].b + palette[1].b) / 2,
+            };
+            palette[3] = { 0, 0, 0 };
+        }
+    }
+
+    void writeBlock(uint8_t* out, const uint16_t color0, const uint16_t color1, const uint32_t indices)
+    {
+        out[0] = color0 & 0xff;
+        out[1] = color0 >> 8;
+        out[2] = color1 & 0xff;
+        out[3] = color1 >> 8;
+        out[4] = indices & 0xff;
+        out[5] = (indices >> 8) & 0xff;
+        out[6] = (indices >> 16) & 0xff;
+        out[7] = indices >> 24;
+    }
+
+    void encodeBlock(const uint8_t pixels[16][4], uint8_t* out)
+    {
+        bool hasTransparent = false;
+        uint32_t opaqueCount = 0;
+        float mean[3] = { 0, 0, 0 };
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            if (pixels[i][3] < 128)
+            {
+                hasTransparent = true;
+                continue;
+            }
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                mean[c] += pixels[i][c];
+            }
+            ++opaqueCount;
+        }
+
+        if (opaqueCount == 0)
+        {
+            writeBlock(out, 0, 0, 0xffffffff);
+            return;
+        }
+
+        for (float& value : mean)
+        {
+            value /= opaqueCount;
+        }
+
+        // principal axis of the opaque colors by power iteration on the covariance matrix
+        float covariance[3][3] = {};
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            if (pixels[i][3] < 128)
+            {
+                continue;
+            }
+            const float d[3] = { pixels[i][0] - mean[0], pixels[i][1] - mean[1], pixels[i][2] - mean[2] };
+            for (uint32_t a = 0; a < 3; ++a)
+            {
+                for (uint32_t b = 0; b < 3; ++b)
+                {
+                    covariance[a][b] += d[a] * d[b];
+                }
+            }
+        }
+
+        float axis[3] = { 1, 1, 1 };
+        for (uint32_t iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[3];
+            for (uint32_t a = 0; a < 3; ++a)
+            {
+                next[a] = covariance[a][0] * axis[0] + covariance[a][1] * axis[1] + covariance[a][2] * axis[2];
+            }
+            const float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+            if (length < 1e-6f)
+            {
+                break;
+            }
+            for (uint32_t a = 0; a < 3; ++a)
+            {
+                axis[a] = next[a] / length;
+            }
+        }
+
+        float minT = 0.0f, maxT = 0.0f;
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            if (pixels[i][3] < 128)
+            {
+                continue;
+            }
+            const float t = (pixels[i][0] - mean[0]) * axis[0] + (pixels[i][1] - mean[1]) * axis[1] + (pixels[i][2] - mean[2]) * axis[2];
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+
+        uint16_t color0 = packColor565(mean[0] + maxT * axis[0], mean[1] + maxT * axis[1], mean[2] + maxT * axis[2]);
+        uint16_t color1 = packColor565(mean[0] + minT * axis[0], mean[1] + minT * axis[1], mean[2] + minT * axis[2]);
+        if ((hasTransparent && color0 > color1) || (!hasTransparent && color0 < color1))
+        {
+            std::swap(color0, color1);
+        }
+
+        Color palette[4];
+        getPalette(color0, color1, palette);
+        const uint32_t paletteSize = color0 > color1 ? 4 : 3;
+
+        uint32_t indices = 0;
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            uint32_t bestIndex = 3;
+            if (pixels[i][3] >= 128)
+            {
+                int32_t bestDistance = INT32_MAX;
+                for (uint32_t p = 0; p < paletteSize; ++p)
+                {
+                    const int32_t dr = pixels[i][0] - palette[p].r;
+                    const int32_t dg = pixels[i][1] - palette[p].g;
+                    const int32_t db = pixels[i][2] - palette[p].b;
+                    const int32_t distance = dr * dr + dg * dg + db * db;
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        bestIndex = p;
+                    }
+                }
+            }
+            indices |= bestIndex << (2 * i);
+        }
+
+        writeBlock(out, color0, color1, indices);
+    }
+}
+
+BakedTextureView eng::parseBakedTexture(const char* bytes, const size_t size)
+{
+    if (size < sizeof(BakedTextureHeader))
+    {
+        throw std::runtime_error("Baked texture is truncated");
+    }
+
+    const auto header = reinterpret_cast<const BakedTextureHeader*>(bytes);
+    if (header->magic != BAKED_TEXTURE_MAGIC || header->version != BAKED_TEXTURE_VERSION)
+    {
+        throw std::runtime_error("Baked texture has an unsupported header");
+    }
+    if (header->format != BakedTextureFormat::RGBA8Srgb && header->format != BakedTextureFormat::BC1Srgb)
+    {
+        throw std::runtime_error("Baked texture has an unknown format");
+    }
+    if (header->mipLevels == 0 || header->mipLevels > 32)
+    {
+        throw std::runtime_error("Baked texture has an invalid mip level count");
+    }
+
+    const size_t dataOffset = sizeof(BakedTextureHeader) + header->mipLevels * sizeof(BakedTextureLevel);
+    if (size < dataOffset)
+    {
+        throw std::runtime_error("Baked texture is truncated");
+    }
+
+    const BakedTextureView view {
+        .header = header,
+        .levels = reinterpret_cast<const BakedTextureLevel*>(bytes + sizeof(BakedTextureHeader)),
+        .data = bytes + dataOffset,
+        .dataSize = size - dataOffset,
+    };
+
+    for (uint32_t i = 0; i < header->mipLevels; ++i)
+    {
+        const auto& level = view.levels[i];
+        const uint32_t expectedSize = header->format == BakedTextureFormat::BC1Srgb
+            ? getBC1Size(level.width, level.height)
+            : level.width * level.height * 4;
+        if (level.size != expectedSize || static_cast<size_t>(level.offset) + level.size > view.dataSize)
+        {
+            throw std::runtime_error("Baked texture has an invalid mip level");
+        }
+    }
+
+    return view;
+}
+
+std::string eng::getBakedTexturePath(const std::string& texturePath)
+{
+    constexpr std::string_view prefix = "resources/textures/";
+    if (!texturePath.starts_with(prefix))
+    {
+        return {};
+    }
+
+    std::string name = texturePath.substr(prefix.size(), texturePath.rfind('.') - prefix.size());
+    std::replace(name.begin(), name.end(), '/', '_');
+    return "baked/" + name + ".tex";
+}
+
+void eng::encodeBC1(const uint8_t* rgba, const uint32_t width, const uint32_t height, std::vector<uint8_t>& blocks)
+{
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    blocks.resize(getBC1Size(width, height));
+
+    for (uint32_t by = 0; by < blocksY; ++by)
+    {
+        for (uint32_t bx = 0; bx < blocksX; ++bx)
+        {
+            // partial blocks at the edges repeat the last row/column
+            uint8_t pixels[16][4];
+            for (uint32_t y = 0; y < 4; ++y)
+            {
+                for (uint32_t x = 0; x < 4; ++x)
+                {
+                    const uint32_t sx = std::min(4 * bx + x, width - 1);
+                    const uint32_t sy = std::min(4 * by + y, height - 1);
+                    std::memcpy(pixels[4 * y + x], rgba + 4 * (sy * width + sx), 4);
+                }
+            }
+            encodeBlock(pixels, blocks.data() + 8 * (by * blocksX + bx));
+        }
+    }
+}
+
+void eng::decodeBC1(const uint8_t* blocks, const uint32_t width, const uint32_t height, std::vector<uint8_t>& rgba)
+{
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    rgba.resize(4 * width * height);
+
+    for (uint32_t by = 0; by < blocksY; ++by)
+    {
+        for (uint32_t bx = 0; bx < blocksX; ++bx)
+        {
+            const uint8_t* block = blocks + 8 * (by * blocksX + bx);
+            const uint16_t color0 = block[0] | (block[1] << 8);
+            const uint16_t color1 = block[2] | (block[3] << 8);
+            const uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+
+            Color palette[4];
+            getPalette(color0, color1, palette);
+            const bool transparentIndex3 = color0 <= color1;
+
+            for (uint32_t y = 0; y < 4 && 4 * by + y < height; ++y)
+            {
+                for (uint32_t x = 0; x < 4 && 4 * bx + x < width; ++x)
+                {
+                    const uint32_t index = (indices >> (2 * (4 * y + x))) & 3;
+                    uint8_t* pixel = rgba.data() + 4 * ((4 * by + y) * width + 4 * bx + x);
+                    pixel[0] = palette[index].r;
+                    pixel[1] = palette[index].g;
+                    pixel[2] = palette[index].b;
+                    pixel[3] = (transparentIndex3 && index == 3) ? 0 : 255;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Container written by texture_baker: a BakedTextureHeader, one BakedTextureLevel per mip level,
+// then the level data. Level offsets are relative to the start of the level data.
+namespace eng
+{
+    constexpr uint32_t BAKED_TEXTURE_MAGIC = 0x5854444c; // "LDTX"
+    constexpr uint32_t BAKED_TEXTURE_VERSION = 1;
+
+    enum class BakedTextureFormat : uint32_t
+    {
+        RGBA8Srgb = 0,
+        BC1Srgb = 1,
+    };
+
+    struct BakedTextureHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        BakedTextureFormat format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t mipLevels;
+    };
+
+    struct BakedTextureLevel
+    {
+        uint32_t offset;
+        uint32_t size;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    struct BakedTextureView
+    {
+        const BakedTextureHeader* header;
+        const BakedTextureLevel* levels;
+        const char* data;
+        size_t dataSize;
+    };
+
+    // validates the container and returns pointers into it, throws std::runtime_error if it is malformed
+    BakedTextureView parseBakedTexture(const char* bytes, const size_t size);
+
+    // maps "resources/textures/dir/name.png" to "baked/dir_name.tex"
+    std::string getBakedTexturePath(const std::string& texturePath);
+
+    // BC1 with 1-bit alpha, rgba is tightly packed 8-bit RGBA
+    void encodeBC1(const uint8_t* rgba, const uint32_t width, const uint32_t height, std::vector<uint8_t>& blocks);
+    void decodeBC1(const uint8_t* blocks, const uint32_t width, const uint32_t height, std::vector<uint8_t>& rgba);
+
+    constexpr uint32_t getBC1Size(const uint32_t width, const uint32_t height)
+    {
+        return 8 * ((width + 3) / 4) * ((height + 3) / 4);
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Body/BodyID.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace fff
+{
+    // Maps bodies to whatever game entity owns them in constant time. Jolt hands out body IDs as small dense
+    // indices plus a sequence number, so entries live in a table indexed by the body index and keep the full
+    // ID to tell a reused index apart from the body that was registered.
+    template<typename Entity>
+    class BodyRegistry
+    {
+        struct Entry
+        {
+            uint32_t bodyID = JPH::BodyID::cInvalidBodyID;
+            Entity entity;
+        };
+
+        std::vector<Entry> entries;
+
+    public:
+        // replaces the entity when the body is registered already
+        void set(const JPH::BodyID body, const Entity& entity)
+        {
+            const uint32_t index = body.GetIndex();
+            if (index >= entries.size())
+            {
+                entries.resize(index + 1);
+            }
+            entries[index] = Entry {
+                .bodyID = body.GetIndexAndSequenceNumber(),
+                .entity = entity,
+            };
+        }
+
+        void remove(const JPH::BodyID body)
+        {
+            const uint32_t index = body.GetIndex();
+            if (index < entries.size() && entries[index].bodyID == body.GetIndexAndSequenceNumber())
+            {
+                entries[index] = Entry{};
+            }
+        }
+
+        Entity* find(const JPH::BodyID body)
+        {
+            const uint32_t index = body.GetIndex();
+            if (body.IsInvalid() || index >= entries.size() || entries[index].bodyID != body.GetIndexAndSequenceNumber())
+            {
+                return nullptr;
+            }
+            return &entries[index].entity;
+        }
+
+        const Entity* find(const JPH::BodyID body) const
+        {
+            return const_cast<BodyRegistry*>(this)->find(body);
+        }
+
+        void clear()
+        {
+            entries.clear();
+        }
+    };
+}
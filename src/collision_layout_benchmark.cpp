@@ -0,0 +1,127 @@
+#include "dungeon.hpp"
+#include "jph_glm_convert.hpp"
+#include "physics.hpp"
+
+#include <Jolt/Core/JobSystem.h>
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <Jolt/Physics/Collision/Shape/BoxShape.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+#include <iostream>
+#include <memory>
+#include <random>
+
+// the largest of the game's levels
+constexpr Dungeon::GenerationParams DUNGEON_PARAMS {
+    .seed = 1,
+    .width = 70,
+    .height = 70,
+    .partitionedRoomCount = 100,
+    .targetRoomCount = 14,
+    .minSplitDimension = 6,
+    .minPortalOverlap = 2,
+};
+constexpr uint32_t DYNAMIC_BOXES = 512;
+constexpr uint32_t STEPS = 300;
+// rays per step, fresh every step so none come from the cache
+constexpr uint32_t RAYS_PER_STEP = 4096;
+constexpr float RAY_LENGTH = 8.0f;
+
+static const char* getLayoutName(const Dungeon::CollisionLayout layout)
+{
+    switch (layout)
+    {
+        case Dungeon::CollisionLayout::SeparateBodies: return "separate bodies";
+        case Dungeon::CollisionLayout::CompoundPerRoom: return "compound per room";
+        case Dungeon::CollisionLayout::CompoundLevel: return "compound level";
+    }
+    return "";
+}
+
+static double getMilliseconds(const std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Builds the same dungeon once per collision layout and compares them: the time to create the static bodies,
+// Jolt's update with boxes falling and sliding around the rooms, and batched raycasts against the level
+int main()
+{
+    const std::unique_ptr<JPH::JobSystem> jobSystem(fff::createJobSystem());
+    const Dungeon dungeon = Dungeon::generate(DUNGEON_PARAMS);
+
+    for (const auto layout : { Dungeon::CollisionLayout::SeparateBodies, Dungeon::CollisionLayout::CompoundPerRoom,
+            Dungeon::CollisionLayout::CompoundLevel })
+    {
+        const std::unique_ptr<fff::PhysicsWorldInterface> physicsWorld(fff::createPhysicsWorld(*jobSystem));
+        JPH::PhysicsSystem& physicsSystem = physicsWorld->getPhysicsSystem();
+        std::vector<JPH::BodyID> mapBodies;
+        std::vector<JPH::Ref<JPH::Shape>> shapeRefs;
+
+        const auto createStart = std::chrono::steady_clock::now();
+        dungeon.createPhysicsBodies(2, 1, 0.5, mapBodies, shapeRefs, physicsSystem, layout);
+        physicsSystem.OptimizeBroadPhase();
+        const double createTime = getMilliseconds(createStart);
+
+        // same boxes and rays for every layout
+        std::mt19937 prng(1);
+        const auto randomPointInRoom = [&](const float y)
+        {
+            const auto& room = dungeon.rooms[prng() % dungeon.rooms.size()];
+            std::uniform_real_distribution<float> x(room.x + 0.5f, room.x + room.width - 0.5f);
+            std::uniform_real_distribution<float> z(room.y + 0.5f, room.y + room.height - 0.5f);
+            return glm::vec3(x(prng), y, z(prng));
+        };
+
+        const JPH::Ref<JPH::Shape> boxShape = new JPH::BoxShape(JPH::Vec3(0.25f, 0.25f, 0.25f));
+        std::uniform_real_distribution<float> dropHeight(0.5f, 3.0f);
+        std::uniform_real_distribution<float> speed(-4.0f, 4.0f);
+        JPH::BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
+        for (uint32_t i = 0; i < DYNAMIC_BOXES; ++i)
+        {
+            JPH::BodyCreationSettings settings(boxShape, glm_to_jph(randomPointInRoom(dropHeight(prng))), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, 1);
+            settings.mLinearVelocity = JPH::Vec3(speed(prng), 0, speed(prng));
+            bodyInterface.CreateAndAddBody(settings, JPH::EActivation::Activate);
+        }
+
+        std::vector<fff::RayQuery> rays(RAYS_PER_STEP);
+        std::vector<fff::RayHit> hits(RAYS_PER_STEP);
+        std::uniform_real_distribution<float> angle(0.0f, glm::two_pi<float>());
+        double updateTime = 0.0;
+        double maxUpdateTime = 0.0;
+        double rayTime = 0.0;
+        uint32_t rayHits = 0;
+        for (uint32_t step = 0; step < STEPS; ++step)
+        {
+            physicsWorld->update(physicsWorld->getStepTime());
+            const auto& stats = physicsWorld->getStepStats();
+            updateTime += stats.updateTime;
+            maxUpdateTime = std::max<double>(maxUpdateTime, stats.updateTime);
+
+            for (auto& ray : rays)
+            {
+                const float a = angle(prng);
+                ray = fff::RayQuery {
+                    .origin = randomPointInRoom(1.0f),
+                    .direction = RAY_LENGTH * glm::vec3(std::cos(a), 0, std::sin(a)),
+                };
+            }
+            const auto rayStart = std::chrono::steady_clock::now();
+            physicsWorld->castRays(rays, hits);
+            rayTime += getMilliseconds(rayStart);
+            for (const auto& hit : hits)
+            {
+                rayHits += hit.hit;
+            }
+        }
+
+        std::cout << getLayoutName(layout) << ": " << mapBodies.size() << " static bodies created in " << createTime << " ms, "
+            << "update " << updateTime / STEPS << " ms/step mean " << maxUpdateTime << " ms max, "
+            << RAYS_PER_STEP << " rays " << rayTime / STEPS << " ms/batch, "
+            << static_cast<double>(rayHits) / (STEPS * RAYS_PER_STEP) << " hit rate" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,322 @@
+#pragma once
+
+#include "robin_hood_table.hpp"
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/StateRecorder.h>
+#include <Jolt/Core/UnorderedMap.h>
+#include <Jolt/Physics/Body/Body.h>
+#include <Jolt/Physics/Collision/ContactListener.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Contact tracking behind PhysicsWorld's collision callbacks and contact queries. Kept out of physics.cpp so the
+// pair table can be benchmarked without a physics system.
+namespace fff
+{
+    struct CollisionPairRecord
+    {
+        JPH::BodyID bodies[2];
+        std::vector<std::pair<JPH::SubShapeIDPair, JPH::ContactManifold>> contacts;
+    };
+
+    // body IDs ordered so either order finds the same pair
+    inline uint64_t getPairKey(JPH::BodyID body0, JPH::BodyID body1)
+    {
+        if (body1 < body0)
+        {
+            std::swap(body0, body1);
+        }
+        return (static_cast<uint64_t>(body0.GetIndexAndSequenceNumber()) << 32) | body1.GetIndexAndSequenceNumber();
+    }
+
+    // contact callbacks recorded during a step, applied to the pair table in sequence order once the step is done
+    struct ContactEvent
+    {
+        uint64_t sequence = 0;
+        bool removed = false;
+        JPH::BodyID bodies[2] = {};
+        JPH::SubShapeIDPair subShapePair = {};
+        JPH::ContactManifold manifold = {};
+        // Jolt creates a contact constraint for the manifold
+        bool constraint = false;
+    };
+
+    // one per thread so recording doesn't contend, on separate cache lines
+    struct alignas(64) ContactEventBuffer
+    {
+        std::vector<ContactEvent> events;
+    };
+
+    // stable per thread for the life of the process
+    inline uint32_t getThreadSlot()
+    {
+        static std::atomic<uint32_t> nextSlot = 0;
+        thread_local const uint32_t slot = nextSlot++;
+        return slot;
+    }
+
+    struct ContactListener final: public JPH::ContactListener
+    {
+        static constexpr uint32_t MAX_THREAD_BUFFERS = 64;
+
+        std::atomic<uint64_t> nextSequence = 0;
+        ContactEventBuffer threadBuffers[MAX_THREAD_BUFFERS];
+        // threads past the per-thread buffers share this one
+        std::mutex overflowMutex;
+        ContactEventBuffer overflowBuffer;
+        // sequence and event, sorted instead of the events themselves, which carry a whole manifold
+        std::vector<std::pair<uint64_t, const ContactEvent*>> mergedEvents;
+        // pair key to index in collisionPairs, which stays dense
+        fff::RobinHoodTable<uint32_t> collisionPairsMap;
+        std::vector<CollisionPairRecord> collisionPairs;
+        std::vector<std::pair<JPH::BodyID, JPH::BodyID>> addedPairs;
+        std::vector<std::pair<JPH::BodyID, JPH::BodyID>> removedPairs;
+        JPH::UnorderedMap<JPH::SubShapeIDPair, uint64_t> subShapePairsMap;
+        // contact constraints Jolt created in the last step, counted by MergeEvents
+        uint32_t contactConstraints = 0;
+
+        const CollisionPairRecord* FindPair(const JPH::BodyID body0, const JPH::BodyID body1) const
+        {
+            const uint32_t* pairIndex = collisionPairsMap.find(getPairKey(body0, body1));
+            return pairIndex ? &collisionPairs[*pairIndex] : nullptr;
+        }
+
+        CollisionPairRecord& GetPair(const JPH::BodyID body0, const JPH::BodyID body1)
+        {
+            const uint64_t key = getPairKey(body0, body1);
+            if (const uint32_t* pairIndex = collisionPairsMap.find(key))
+            {
+                return collisionPairs[*pairIndex];
+            }
+
+            collisionPairsMap.insert(key, collisionPairs.size());
+            if (body1 < body0)
+            {
+                collisionPairs.push_back({{ body1, body0 }, {}});
+            }
+            else
+            {
+                collisionPairs.push_back({{ body0, body1 }, {}});
+            }
+            addedPairs.emplace_back(collisionPairs.back().bodies[0], collisionPairs.back().bodies[1]);
+
+            return collisionPairs.back();
+        }
+
+        void RecordEvent(ContactEvent&& event)
+        {
+            event.sequence = nextSequence.fetch_add(1, std::memory_order_relaxed);
+            if (const uint32_t slot = getThreadSlot(); slot < MAX_THREAD_BUFFERS)
+            {
+                threadBuffers[slot].events.push_back(std::move(event));
+            }
+            else
+            {
+                std::lock_guard lock(overflowMutex);
+                overflowBuffer.events.push_back(std::move(event));
+            }
+        }
+
+        // Jolt reports every manifold it keeps, and makes a constraint of each one unless it's a sensor contact
+        // or neither body is dynamic
+        void OnContactAdded(const JPH::Body& body0, const JPH::Body& body1, const JPH::ContactManifold& manifold, JPH::ContactSettings& settings) override
+        {
+            RecordEvent(ContactEvent {
+                    .removed = false,
+                    .bodies = { body0.GetID(), body1.GetID() },
+                    .subShapePair = JPH::SubShapeIDPair(body0.GetID(), manifold.mSubShapeID1, body1.GetID(), manifold.mSubShapeID2),
+                    .manifold = manifold,
+                    .constraint = !settings.mIsSensor && (body0.IsDynamic() || body1.IsDynamic()),
+                });
+        }
+
+        void OnContactPersisted(const JPH::Body& body0, const JPH::Body& body1, const JPH::ContactManifold& manifold, JPH::ContactSettings& settings) override
+        {
+            OnContactAdded(body0, body1, manifold, settings);
+        }
+
+        void OnContactRemoved(const JPH::SubShapeIDPair& subShapeIDPair) override
+        {
+            RecordEvent(ContactEvent {
+                    .removed = true,
+                    .subShapePair = subShapeIDPair,
+                });
+        }
+
+        // called on one thread after the physics update, nothing is recording then
+        void MergeEvents()
+        {
+            mergedEvents.clear();
+            contactConstraints = 0;
+            const auto gather = [this](const ContactEventBuffer& buffer)
+            {
+                for (const auto& event : buffer.events)
+                {
+                    mergedEvents.emplace_back(event.sequence, &event);
+                }
+            };
+            for (const auto& buffer : threadBuffers)
+            {
+                gather(buffer);
+            }
+            gather(overflowBuffer);
+
+            std::sort(mergedEvents.begin(), mergedEvents.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+            for (const auto& entry : mergedEvents)
+            {
+                const ContactEvent& event = *entry.second;
+                contactConstraints += event.constraint;
+                if (event.removed)
+                {
+                    ApplyContactRemoved(event.subShapePair);
+                }
+                else
+                {
+                    ApplyContactAdded(event.bodies[0], event.bodies[1], event.subShapePair, event.manifold);
+                }
+            }
+
+            // the buffers keep their memory for the next step
+            for (auto& buffer : threadBuffers)
+            {
+                buffer.events.clear();
+            }
+            overflowBuffer.events.clear();
+        }
+
+        void SaveState(JPH::StateRecorder& stream) const
+        {
+            stream.Write(static_cast<uint32_t>(collisionPairs.size()));
+            for (const auto& pair : collisionPairs)
+            {
+                stream.Write(pair.bodies[0]);
+                stream.Write(pair.bodies[1]);
+                stream.Write(static_cast<uint32_t>(pair.contacts.size()));
+                for (const auto& [idPair, manifold] : pair.contacts)
+                {
+                    stream.Write(idPair);
+                    stream.Write(manifold.mBaseOffset);
+                    stream.Write(manifold.mWorldSpaceNormal);
+                    stream.Write(manifold.mPenetrationDepth);
+                    stream.Write(manifold.mSubShapeID1);
+                    stream.Write(manifold.mSubShapeID2);
+                    stream.Write(static_cast<uint32_t>(manifold.mRelativeContactPointsOn1.size()));
+                    for (uint32_t i = 0; i < manifold.mRelativeContactPointsOn1.size(); ++i)
+                    {
+                        stream.Write(manifold.mRelativeContactPointsOn1[i]);
+                        stream.Write(manifold.mRelativeContactPointsOn2[i]);
+                    }
+                }
+            }
+        }
+
+        // replaces the pair table without reporting enter or exit for the pairs that changed
+        bool RestoreState(JPH::StateRecorder& stream)
+        {
+            for (auto& buffer : threadBuffers)
+            {
+                buffer.events.clear();
+            }
+            overflowBuffer.events.clear();
+            addedPairs.clear();
+            removedPairs.clear();
+            collisionPairsMap.clear();
+            subShapePairsMap.clear();
+
+            uint32_t pairCount = 0;
+            stream.Read(pairCount);
+            collisionPairs.resize(pairCount);
+            for (uint32_t pairIndex = 0; pairIndex < pairCount && !stream.IsFailed(); ++pairIndex)
+            {
+                auto& pair = collisionPairs[pairIndex];
+                stream.Read(pair.bodies[0]);
+                stream.Read(pair.bodies[1]);
+                const uint64_t key = getPairKey(pair.bodies[0], pair.bodies[1]);
+                if (stream.IsFailed() || collisionPairsMap.find(key))
+                {
+                    return false;
+                }
+                collisionPairsMap.insert(key, pairIndex);
+
+                uint32_t contactCount = 0;
+                stream.Read(contactCount);
+                pair.contacts.resize(contactCount);
+                for (auto& [idPair, manifold] : pair.contacts)
+                {
+                    stream.Read(idPair);
+                    stream.Read(manifold.mBaseOffset);
+                    stream.Read(manifold.mWorldSpaceNormal);
+                    stream.Read(manifold.mPenetrationDepth);
+                    stream.Read(manifold.mSubShapeID1);
+                    stream.Read(manifold.mSubShapeID2);
+                    uint32_t pointCount = 0;
+                    stream.Read(pointCount);
+                    if (pointCount > JPH::ContactPoints::capacity())
+                    {
+                        return false;
+                    }
+                    manifold.mRelativeContactPointsOn1.resize(pointCount);
+                    manifold.mRelativeContactPointsOn2.resize(pointCount);
+                    for (uint32_t i = 0; i < pointCount; ++i)
+                    {
+                        stream.Read(manifold.mRelativeContactPointsOn1[i]);
+                        stream.Read(manifold.mRelativeContactPointsOn2[i]);
+                    }
+                    subShapePairsMap[idPair] = key;
+                }
+            }
+
+            return !stream.IsFailed();
+        }
+
+        void ApplyContactAdded(const JPH::BodyID body0, const JPH::BodyID body1, const JPH::SubShapeIDPair& idPair, const JPH::ContactManifold& manifold)
+        {
+            auto& pair = GetPair(body0, body1);
+            subShapePairsMap[idPair] = getPairKey(body0, body1);
+
+            for (uint32_t i = 0; i < pair.contacts.size(); ++i)
+            {
+                if (pair.contacts[i].first == idPair)
+                {
+                    pair.contacts[i].second = manifold;
+                    return;
+                }
+            }
+            pair.contacts.push_back({ idPair, manifold });
+        }
+
+        void ApplyContactRemoved(const JPH::SubShapeIDPair& subShapeIDPair)
+        {
+            auto iter = subShapePairsMap.find(subShapeIDPair);
+            if (iter == subShapePairsMap.end()) return;
+            const uint64_t key = iter->second;
+            subShapePairsMap.erase(iter);
+
+            const uint32_t* pairIndexValue = collisionPairsMap.find(key);
+            if (!pairIndexValue) return;
+            const uint32_t pairIndex = *pairIndexValue;
+            auto& pair = collisionPairs[pairIndex];
+            auto contactIter = std::find_if(pair.contacts.begin(), pair.contacts.end(), [&](const auto& c) {
+                    return c.first == subShapeIDPair;
+                });
+            if (contactIter == pair.contacts.end()) return;
+            pair.contacts.erase(contactIter);
+
+            if (pair.contacts.empty())
+            {
+                removedPairs.emplace_back(pair.bodies[0], pair.bodies[1]);
+                collisionPairsMap.erase(key);
+                if (pairIndex < collisionPairs.size() - 1)
+                {
+                    pair = std::move(collisionPairs.back());
+                    *collisionPairsMap.find(getPairKey(pair.bodies[0], pair.bodies[1])) = pairIndex;
+                }
+                collisionPairs.pop_back();
+            }
+        }
+    };
+}
@@ -0,0 +1,153 @@
+#include "contact_listener.hpp"
+
+#include <Jolt/Physics/Collision/Shape/SubShapeID.h>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <unordered_set>
+
+using fff::ContactEvent;
+using fff::ContactListener;
+
+// simultaneous body pairs in contact once the table has filled, each with one or two sub-shape contacts
+constexpr uint32_t PAIR_COUNT = 4096;
+constexpr uint32_t BODY_COUNT = 16384;
+constexpr uint32_t RAMP_STEPS = 64;
+constexpr uint32_t CHURN_STEPS = 240;
+// share of the pairs replaced every churn step
+constexpr uint32_t CHURN_PAIRS = PAIR_COUNT / 10;
+
+struct LivePair
+{
+    JPH::BodyID bodies[2];
+    uint32_t contactCount;
+};
+
+static JPH::SubShapeIDPair getSubShapePair(const LivePair& pair, const uint32_t contact)
+{
+    JPH::SubShapeIDCreator creator;
+    return JPH::SubShapeIDPair(pair.bodies[0], creator.PushID(contact, 2).GetID(), pair.bodies[1], JPH::SubShapeID());
+}
+
+// Feeds contact callbacks for thousands of pairs through ContactListener the way a physics step would: every
+// live contact is reported again as persisted, new pairs are added and old ones removed. The pair table grows
+// from empty, churns at full size and drains again. Reports the time per step and probe lengths for each
+// phase, and fails if a live pair goes missing.
+int main()
+{
+    JPH::RegisterDefaultAllocator();
+
+    ContactListener listener;
+
+    std::mt19937_64 prng(1);
+    std::vector<LivePair> livePairs;
+    std::unordered_set<uint64_t> liveKeys;
+
+    const auto addPair = [&]
+    {
+        LivePair pair;
+        uint64_t key;
+        do
+        {
+            const uint32_t body0 = prng() % BODY_COUNT;
+            const uint32_t body1 = prng() % BODY_COUNT;
+            pair.bodies[0] = JPH::BodyID(std::min(body0, body1));
+            pair.bodies[1] = JPH::BodyID(std::max(body0, body1));
+            key = fff::getPairKey(pair.bodies[0], pair.bodies[1]);
+        } while (pair.bodies[0] == pair.bodies[1] || liveKeys.contains(key));
+
+        pair.contactCount = 1 + prng() % 2;
+        liveKeys.insert(key);
+        livePairs.push_back(pair);
+    };
+
+    const auto removePair = [&]
+    {
+        const size_t index = prng() % livePairs.size();
+        const LivePair pair = livePairs[index];
+        livePairs[index] = livePairs.back();
+        livePairs.pop_back();
+        liveKeys.erase(fff::getPairKey(pair.bodies[0], pair.bodies[1]));
+
+        for (uint32_t contact = 0; contact < pair.contactCount; ++contact)
+        {
+            listener.RecordEvent(ContactEvent { .removed = true, .subShapePair = getSubShapePair(pair, contact) });
+        }
+    };
+
+    const auto runStep = [&](const uint32_t added, const uint32_t removed)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        for (uint32_t i = 0; i < removed && !livePairs.empty(); ++i)
+        {
+            removePair();
+        }
+        for (uint32_t i = 0; i < added; ++i)
+        {
+            addPair();
+        }
+
+        // new and persisted contacts are reported the same way
+        for (const auto& pair : livePairs)
+        {
+            for (uint32_t contact = 0; contact < pair.contactCount; ++contact)
+            {
+                listener.RecordEvent(ContactEvent {
+                        .bodies = { pair.bodies[0], pair.bodies[1] },
+                        .subShapePair = getSubShapePair(pair, contact),
+                    });
+            }
+        }
+        listener.MergeEvents();
+        listener.addedPairs.clear();
+        listener.removedPairs.clear();
+
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    bool consistent = true;
+    const auto runPhase = [&](const std::string_view name, const uint32_t steps, const uint32_t added, const uint32_t removed)
+    {
+        double totalTime = 0.0;
+        double maxTime = 0.0;
+        for (uint32_t step = 0; step < steps; ++step)
+        {
+            const double time = runStep(added, removed);
+            totalTime += time;
+            maxTime = std::max(maxTime, time);
+        }
+
+        if (listener.collisionPairs.size() != livePairs.size())
+        {
+            consistent = false;
+        }
+        for (const auto& pair : livePairs)
+        {
+            const auto record = listener.FindPair(pair.bodies[0], pair.bodies[1]);
+            if (!record || record->contacts.size() != pair.contactCount)
+            {
+                consistent = false;
+            }
+        }
+
+        const auto probes = listener.collisionPairsMap.getProbeStats();
+        std::cout << name << ": " << steps << " steps, " << livePairs.size() << " pairs, "
+            << totalTime / steps << " ms/step mean, " << maxTime << " ms max, "
+            << "probe length " << probes.meanLength << " mean " << probes.maxLength << " max, "
+            << probes.capacity << " slots" << std::endl;
+    };
+
+    runPhase("grow", RAMP_STEPS, PAIR_COUNT / RAMP_STEPS, 0);
+    runPhase("churn", CHURN_STEPS, CHURN_PAIRS, CHURN_PAIRS);
+    runPhase("drain", RAMP_STEPS, 0, PAIR_COUNT / RAMP_STEPS);
+    runPhase("regrow", RAMP_STEPS, PAIR_COUNT / RAMP_STEPS, 0);
+
+    if (!consistent)
+    {
+        std::cerr << "pair table lost track of live pairs" << std::endl;
+        return 1;
+    }
+    return 0;
+}
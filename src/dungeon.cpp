@@ -1,9 +1,12 @@
 #include "dungeon.hpp"
 
+#include <algorithm>
 #include <numeric>
 #include <queue>
+#include <stdexcept>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
 #include <Jolt/Physics/Collision/Shape/BoxShape.h>
+#include <Jolt/Physics/Collision/Shape/StaticCompoundShape.h>
 #include "jph_glm_convert.hpp"
 
 constexpr uint32_t U32_MAX = std::numeric_limits<uint32_t>::max();
@@ -639,17 +642,77 @@ Dungeon::Geometry Dungeon::createGeometry(const float wallHeight, const float do
     return geometry;
 }
 
+Dungeon::RoomMap Dungeon::createRoomMap() const
+{
+    RoomMap map { .width = 0, .height = 0 };
+    for (const auto& room : rooms)
+    {
+        map.width = std::max(map.width, room.x + room.width);
+        map.height = std::max(map.height, room.y + room.height);
+    }
+
+    map.cells.assign(map.width * map.height, U32_MAX);
+    for (uint32_t roomi = 0; roomi < rooms.size(); ++roomi)
+    {
+        const auto& room = rooms[roomi];
+        for (uint32_t y = room.y; y < room.y + room.height; ++y)
+        {
+            std::fill_n(map.cells.begin() + y * map.width + room.x, room.width, roomi);
+        }
+    }
+
+    return map;
+}
+
 void Dungeon::createPhysicsBodies(const float wallHeight, const float doorWidth, const float wallThickness,
-        std::vector<JPH::BodyID>& bodies, std::vector<JPH::Ref<JPH::Shape>>& shapeRefs, JPH::PhysicsSystem& physicsSystem) const
+        std::vector<JPH::BodyID>& bodies, std::vector<JPH::Ref<JPH::Shape>>& shapeRefs, JPH::PhysicsSystem& physicsSystem,
+        const CollisionLayout layout) const
 {
-    std::queue<uint32_t> wallNodeIndices;
+    // bodies are created first and added to the broadphase in one batch at the end
+    JPH::BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
+    const size_t firstBody = bodies.size();
+    // nothing is in the broadphase until the end, so a failure part way only has to destroy what was created
+    const auto destroyCreatedBodies = [&]
+    {
+        const int createdCount = static_cast<int>(bodies.size() - firstBody);
+        if (createdCount > 0)
+        {
+            bodyInterface.DestroyBodies(bodies.data() + firstBody, createdCount);
+        }
+        bodies.resize(firstBody);
+    };
 
-    for (const auto& room : rooms)
+    const auto createBody = [&](const JPH::Shape* shape, const JPH::Vec3 position)
     {
-        bodies.push_back(physicsSystem.GetBodyInterface().CreateAndAddBody(
-                    JPH::BodyCreationSettings(shapeRefs.emplace_back(new JPH::BoxShape(JPH::Vec3(room.width * 0.5, 0.5, room.height * 0.5))),
-                        JPH::Vec3(room.x + 0.5 * room.width, - 0.5, room.y + 0.5 * room.height), JPH::Quat::sIdentity(), JPH::EMotionType::Static, 0),
-                    JPH::EActivation::DontActivate));
+        const JPH::Body* body = bodyInterface.CreateBody(JPH::BodyCreationSettings(shape, position, JPH::Quat::sIdentity(), JPH::EMotionType::Static, 0));
+        if (!body)
+        {
+            destroyCreatedBodies();
+            throw std::runtime_error("Out of physics bodies creating dungeon collision");
+        }
+        bodies.push_back(body->GetID());
+    };
+
+    // boxes go into the compound for their room (or the one for the whole level), or become bodies right away
+    std::vector<JPH::StaticCompoundShapeSettings> compounds(layout == CollisionLayout::CompoundPerRoom ? rooms.size() + 1
+            : layout == CollisionLayout::CompoundLevel ? 1 : 0);
+    const auto addBox = [&](const uint32_t compoundIndex, const JPH::Vec3 halfExtent, const JPH::Vec3 center)
+    {
+        const auto& shape = shapeRefs.emplace_back(new JPH::BoxShape(halfExtent));
+        if (layout == CollisionLayout::SeparateBodies)
+        {
+            createBody(shape, center);
+        }
+        else
+        {
+            compounds[layout == CollisionLayout::CompoundPerRoom ? compoundIndex : 0].AddShape(center, JPH::Quat::sIdentity(), shape);
+        }
+    };
+
+    for (uint32_t roomIndex = 0; roomIndex < rooms.size(); ++roomIndex)
+    {
+        const auto& room = rooms[roomIndex];
+        addBox(roomIndex, JPH::Vec3(room.width * 0.5, 0.5, room.height * 0.5), JPH::Vec3(room.x + 0.5 * room.width, - 0.5, room.y + 0.5 * room.height));
 
         for (uint32_t i = 0; i < 4; ++i)
         {
@@ -694,27 +757,50 @@ void Dungeon::createPhysicsBodies(const float wallHeight, const float doorWidth,
                 glm::vec3 pos(portal.x, 0, portal.y);
                 pos -= 0.5f * doorWidth * dir;
 
-                bodies.push_back(physicsSystem.GetBodyInterface().CreateAndAddBody(
-                            JPH::BodyCreationSettings(shapeRefs.emplace_back(new JPH::BoxShape(glm_to_jph(glm::abs(0.5f * (pos - lastPoint + 0.5f * wallThickness * normal + glm::vec3(0, wallHeight, 0)))))),
-                                glm_to_jph(0.5f * (pos + lastPoint + 0.5f * wallThickness * normal + glm::vec3(0, wallHeight, 0))), JPH::Quat::sIdentity(), JPH::EMotionType::Static, 0),
-                            JPH::EActivation::DontActivate));
+                addBox(roomIndex, glm_to_jph(glm::abs(0.5f * (pos - lastPoint + 0.5f * wallThickness * normal + glm::vec3(0, wallHeight, 0)))),
+                        glm_to_jph(0.5f * (pos + lastPoint + 0.5f * wallThickness * normal + glm::vec3(0, wallHeight, 0))));
 
                 lastPoint = pos + doorWidth * dir;
             }
 
-            bodies.push_back(physicsSystem.GetBodyInterface().CreateAndAddBody(
-                        JPH::BodyCreationSettings(shapeRefs.emplace_back(new JPH::BoxShape(glm_to_jph(glm::abs(0.5f * (points[1] - lastPoint + 0.5f * wallThickness * normal + glm::vec3(0, wallHeight, 0)))))),
-                            glm_to_jph(0.5f * (points[1] + lastPoint + 0.5f * wallThickness * normal + glm::vec3(0, wallHeight, 0))), JPH::Quat::sIdentity(), JPH::EMotionType::Static, 0),
-                        JPH::EActivation::DontActivate));
+            addBox(roomIndex, glm_to_jph(glm::abs(0.5f * (points[1] - lastPoint + 0.5f * wallThickness * normal + glm::vec3(0, wallHeight, 0)))),
+                    glm_to_jph(0.5f * (points[1] + lastPoint + 0.5f * wallThickness * normal + glm::vec3(0, wallHeight, 0))));
         }
     }
 
     for (const auto& obstacle : obstacles)
     {
-        bodies.push_back(physicsSystem.GetBodyInterface().CreateAndAddBody(
-                    JPH::BodyCreationSettings(shapeRefs.emplace_back(new JPH::BoxShape(JPH::Vec3(0.5 * obstacle.width, 0.5 * wallHeight, 0.5 * obstacle.height))),
-                        JPH::Vec3(obstacle.x + 0.5 * obstacle.width, 0.5 * wallHeight, obstacle.y + 0.5 * obstacle.height), JPH::Quat::sIdentity(), JPH::EMotionType::Static, 0),
-                    JPH::EActivation::DontActivate));
+        // obstacles don't record their room, ones outside every room share the last compound
+        const auto room = std::find_if(rooms.begin(), rooms.end(), [&](const auto& room) {
+                return obstacle.x >= room.x && obstacle.y >= room.y && obstacle.x < room.x + room.width && obstacle.y < room.y + room.height;
+            });
+        addBox(room - rooms.begin(), JPH::Vec3(0.5 * obstacle.width, 0.5 * wallHeight, 0.5 * obstacle.height),
+                JPH::Vec3(obstacle.x + 0.5 * obstacle.width, 0.5 * wallHeight, obstacle.y + 0.5 * obstacle.height));
+    }
+
+    for (const auto& compound : compounds)
+    {
+        if (compound.mSubShapes.empty())
+        {
+            continue;
+        }
+
+        const auto result = compound.Create();
+        if (result.HasError())
+        {
+            destroyCreatedBodies();
+            throw std::runtime_error("Failed to create dungeon collision shape: " + std::string(result.GetError()));
+        }
+        createBody(shapeRefs.emplace_back(result.Get()), JPH::Vec3::sZero());
+    }
+
+    // one broadphase insertion for the whole level builds a better tree than adding bodies one at a time
+    const int bodyCount = static_cast<int>(bodies.size() - firstBody);
+    if (bodyCount > 0)
+    {
+        JPH::BodyID* ids = bodies.data() + firstBody;
+        const JPH::BodyInterface::AddState addState = bodyInterface.AddBodiesPrepare(ids, bodyCount);
+        bodyInterface.AddBodiesFinalize(ids, bodyCount, addState, JPH::EActivation::DontActivate);
     }
 }
 
@@ -62,11 +62,41 @@ struct Dungeon
         eng::GeometryDescription obstacleTops;
     };
 
+    // room index per grid cell, for finding the room something is in without searching the rooms
+    struct RoomMap
+    {
+        uint32_t width, height;
+        std::vector<uint32_t> cells;
+
+        // UINT32_MAX outside every room
+        uint32_t find(const float x, const float z) const
+        {
+            if (x < 0 || z < 0 || x >= width || z >= height)
+            {
+                return UINT32_MAX;
+            }
+            return cells[static_cast<uint32_t>(z) * width + static_cast<uint32_t>(x)];
+        }
+    };
+
+    // how static collision is split into bodies. compounds give the broadphase a few large entries instead of
+    // one per floor, wall segment and obstacle
+    enum class CollisionLayout
+    {
+        SeparateBodies,
+        CompoundPerRoom,
+        CompoundLevel,
+    };
+
     static Dungeon generate(const GenerationParams& params);
 
     Geometry createGeometry(const float wallHeight, const float doorWidth, const float wallThickness, const float doorHeight, const float obstacleHeight) const;
 
+    RoomMap createRoomMap() const;
+
+    // throws when Jolt runs out of bodies or a shape fails, destroying the bodies it created first
     void createPhysicsBodies(const float wallHeight, const float doorWidth, const float wallThickness,
-            std::vector<JPH::BodyID>& bodies, std::vector<JPH::Ref<JPH::Shape>>& shapeRefs, JPH::PhysicsSystem& physicsSystem) const;
+            std::vector<JPH::BodyID>& bodies, std::vector<JPH::Ref<JPH::Shape>>& shapeRefs, JPH::PhysicsSystem& physicsSystem,
+            const CollisionLayout layout = CollisionLayout::SeparateBodies) const;
 };
 
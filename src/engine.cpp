@@ -1,17 +1,20 @@
 #include "engine.hpp"
+#include "asset_pack.hpp"
+#include "audio.hpp"
 #include "config.h" // IWYU pragma: keep
 #include "geometry_loader.hpp"
 #include "input_manager.hpp"
 #include "loader_utility.hpp"
 #include "renderer.hpp"
+#include "sprite_atlas.hpp"
 #include "swapchain.hpp"
 #include "texture_loader.hpp"
 #include "vulkan_includes.hpp"
 #include "util.hpp"
 
 #define SDL_MAIN_USE_CALLBACKS 1
-#include <SDL3/SDL_audio.h>
 #include <SDL3/SDL_init.h>
+#include <SDL3/SDL_iostream.h>
 #include <SDL3/SDL_log.h>
 #include <SDL3/SDL_main.h>
 #include <SDL3/SDL_timer.h>
@@ -20,9 +23,10 @@
 
 #include <stb_image.h>
 #include <glm/glm.hpp>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
 #include <optional>
-#include <queue>
 #include <stdexcept>
 #include <sstream>
 #include <vector>
@@ -141,173 +145,6 @@ struct SDLWindowSurfaceWrapper
     }
 };
 
-struct Audio final : eng::AudioInterface
-{
-    struct Sound
-    {
-        uint8_t* pcm = nullptr;
-        uint32_t length = 0;
-        SDL_AudioStream* stream = nullptr;
-
-        Sound() = default;
-
-        Sound(Sound&& s) :
-            pcm(s.pcm),
-            length(s.length),
-            stream(s.stream)
-        {
-            s.pcm = nullptr;
-            s.length = 0;
-            s.stream = nullptr;
-        }
-
-        Sound(Sound&) = delete;
-
-        ~Sound()
-        {
-            SDL_DestroyAudioStream(stream);
-            SDL_free(pcm);
-        }
-
-        Sound& operator=(Sound&& s)
-        {
-            SDL_DestroyAudioStream(stream);
-            SDL_free(pcm);
-            pcm = s.pcm;
-            length = s.length;
-            stream = s.stream;
-            s.pcm = nullptr;
-            s.length = 0;
-            s.stream = nullptr;
-            return *this;
-        }
-
-        Sound& operator=(Sound& s) = delete;
-    };
-
-    SDL_AudioDeviceID device;
-    std::vector<Sound> loops;
-    std::vector<Sound> singleShot;
-    std::queue<uint32_t> freeLoopIndices;
-    std::queue<uint32_t> freeSingleShotIndices;
-
-    Audio() :
-        device(SDL_OpenAudioDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, nullptr))
-    {
-        if (!device)
-        {
-            throw std::runtime_error((std::stringstream{} << "failed to open audio playback device: " << SDL_GetError()).str());
-        }
-    }
-
-    ~Audio()
-    {
-        SDL_CloseAudioDevice(device);
-    }
-
-    uint32_t createSound(const std::string& filePath, std::vector<Sound>& sounds, std::queue<uint32_t>& freeIndices)
-    {
-        Sound sound;
-        SDL_AudioSpec audioSpec;
-        if (!SDL_LoadWAV(filePath.c_str(), &audioSpec, &sound.pcm, &sound.length))
-        {
-            throw std::runtime_error((std::stringstream{} << "failed to load audio from path: " << filePath << ": " << SDL_GetError()).str());
-        }
-
-        sound.stream = SDL_CreateAudioStream(&audioSpec, nullptr);
-        if (!sound.stream)
-        {
-            throw std::runtime_error((std::stringstream{} << "failed to create audio stream: " << SDL_GetError()).str());
-        }
-
-        if (!SDL_BindAudioStream(device, sound.stream))
-        {
-            throw std::runtime_error((std::stringstream{} << "failed to bind audio stream for playback: " << SDL_GetError()).str());
-        }
-
-        if (!SDL_PutAudioStreamData(sound.stream, sound.pcm, sound.length))
-        {
-            throw std::runtime_error((std::stringstream{} << "failed to send audio stream data: " << SDL_GetError()).str());
-        }
-
-        uint32_t index;
-        if (freeIndices.empty())
-        {
-            index = sounds.size();
-            sounds.push_back(std::move(sound));
-        }
-        else
-        {
-            index = freeIndices.front();
-            freeIndices.pop();
-            sounds[index] = std::move(sound);
-        }
-        return index;
-    }
-
-    void destroySound(uint32_t index, std::vector<Sound>& sounds, std::queue<uint32_t>& freeIndices)
-    {
-        if (index < sounds.size() && sounds[index].stream)
-        {
-            sounds[index] = Sound{};
-            freeIndices.push(index);
-        }
-    }
-
-    uint32_t createLoop(const std::string& filePath) override
-    {
-        return createSound(filePath, loops, freeLoopIndices);
-    }
-
-    void destroyLoop(uint32_t index) override
-    {
-        destroySound(index, loops, freeLoopIndices);
-    }
-
-    uint32_t createSingleShot(const std::string& filePath) override
-    {
-        return createSound(filePath, singleShot, freeSingleShotIndices);
-    }
-
-    void destroySingleShot(uint32_t index) override
-    {
-        destroySound(index, singleShot, freeSingleShotIndices);
-    }
-
-    void setMuted(const bool value) override
-    {
-        SDL_SetAudioDeviceGain(device, value ? 0 : 1);
-    }
-
-    void update()
-    {
-        for (const auto& sound : loops)
-        {
-            if (sound.stream)
-            {
-                if (SDL_GetAudioStreamQueued(sound.stream) < static_cast<int>(sound.length))
-                {
-                    if (!SDL_PutAudioStreamData(sound.stream, sound.pcm, sound.length))
-                    {
-                        throw std::runtime_error((std::stringstream{} << "failed to send audio stream data: " << SDL_GetError()).str());
-                    }
-                }
-            }
-        }
-        for (uint32_t i = 0; i < singleShot.size(); ++i)
-        {
-            const auto& sound = singleShot[i];
-            if (sound.stream)
-            {
-                if (SDL_GetAudioStreamQueued(sound.stream) == 0)
-                {
-                    destroySingleShot(i);
-                }
-            }
-        }
-    }
-};
-
 static auto createInstance(const vk::raii::Context& context, const ApplicationInfo& applicationInfo)
 {
     uint32_t numRequiredInstanceExtensions;
@@ -401,6 +238,8 @@ static vk::raii::Device createDevice(const vk::raii::PhysicalDevice& physicalDev
     const auto physicalDeviceFeaturesChain = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
     const auto& physicalDeviceVulkan12Features = physicalDeviceFeaturesChain.get<vk::PhysicalDeviceVulkan12Features>();
     const bool bindlessSupported = (physicalDeviceVulkan12Features.shaderSampledImageArrayNonUniformIndexing && physicalDeviceVulkan12Features.runtimeDescriptorArray);
+    const bool anisotropySupported = physicalDeviceFeaturesChain.get<vk::PhysicalDeviceFeatures2>().features.samplerAnisotropy;
+    const bool textureCompressionBCSupported = physicalDeviceFeaturesChain.get<vk::PhysicalDeviceFeatures2>().features.textureCompressionBC;
 
     const vk::StructureChain deviceCreateInfoChain {
         vk::DeviceCreateInfo {
@@ -412,6 +251,8 @@ static vk::raii::Device createDevice(const vk::raii::PhysicalDevice& physicalDev
         vk::PhysicalDeviceFeatures2 {
             .features = {
                 .multiDrawIndirect = vk::True,
+                .samplerAnisotropy = anisotropySupported ? vk::True : vk::False,
+                .textureCompressionBC = textureCompressionBCSupported ? vk::True : vk::False,
             },
         },
         vk::PhysicalDeviceVulkan12Features {
@@ -478,21 +319,71 @@ struct ResourceLoader final : ResourceLoaderInterface
     const vma::Allocator& allocator;
     TextureLoader& textureLoader;
     GeometryLoader& geometryLoader;
+    SpriteAtlas& spriteAtlas;
+    const AssetPack& assetPack;
     std::vector<Texture>& textures;
+    std::vector<uint32_t>& singleLevelTextures;
     std::vector<RenderGeometry>& geometry;
 
-    ResourceLoader(const vk::raii::Device& device, const vma::Allocator& allocator, TextureLoader& textureLoader, GeometryLoader& geometryLoader, std::vector<Texture>& textures, std::vector<RenderGeometry>& geometry):
+    ResourceLoader(const vk::raii::Device& device, const vma::Allocator& allocator, TextureLoader& textureLoader, GeometryLoader& geometryLoader, SpriteAtlas& spriteAtlas, const AssetPack& assetPack, std::vector<Texture>& textures, std::vector<uint32_t>& singleLevelTextures, std::vector<RenderGeometry>& geometry):
         device(device),
         allocator(allocator),
         textureLoader(textureLoader),
         geometryLoader(geometryLoader),
+        spriteAtlas(spriteAtlas),
+        assetPack(assetPack),
         textures(textures),
+        singleLevelTextures(singleLevelTextures),
         geometry(geometry)
     {
     }
 
-    uint32_t loadTexture(const std::string& filePath, TextureInfo* textureInfo) override
+    // baked textures are read in place from the asset pack, or from a loose baked file kept alive by fileData
+    std::optional<BakedTextureView> findBakedTexture(const std::string& filePath, std::unique_ptr<void, decltype(&SDL_free)>& fileData)
     {
+        if (const auto asset = assetPack.find(filePath); asset && asset->format == AssetFormat::BakedTexture)
+        {
+            return parseBakedTexture(asset->data, asset->size);
+        }
+
+        if (const std::string bakedPath = getBakedTexturePath(filePath); !bakedPath.empty())
+        {
+            size_t size;
+            fileData.reset(SDL_LoadFile(bakedPath.c_str(), &size));
+            if (fileData)
+            {
+                return parseBakedTexture(static_cast<const char*>(fileData.get()), size);
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    uint32_t loadTexture(const std::string& filePath, TextureInfo* textureInfo, const bool mipmapped) override
+    {
+        if (!mipmapped)
+        {
+            singleLevelTextures.push_back(textures.size());
+        }
+
+        // prefer the baked container produced at build time, decoding the PNG is the fallback
+        std::unique_ptr<void, decltype(&SDL_free)> bakedData { nullptr, &SDL_free };
+        if (const auto bakedTexture = findBakedTexture(filePath, bakedData))
+        {
+            uint32_t index = textures.size();
+            textures.push_back(textureLoader.loadBakedTexture(*bakedTexture));
+
+            if (textureInfo)
+            {
+                *textureInfo = {
+                    .width = bakedTexture->header->width,
+                    .height = bakedTexture->header->height,
+                };
+            }
+
+            return index;
+        }
+
         int width, height, components;
         stbi_uc* textureData = stbi_load(filePath.c_str(), &width, &height, &components, 4);
         if (!textureData)
@@ -519,6 +410,71 @@ struct ResourceLoader final : ResourceLoaderInterface
         return index;
     }
 
+    TextureRegion loadSpriteTexture(const std::string& filePath, TextureInfo* textureInfo) override
+    {
+        std::optional<TextureRegion> region;
+        TextureInfo info;
+
+        std::unique_ptr<void, decltype(&SDL_free)> bakedData { nullptr, &SDL_free };
+        if (const auto bakedTexture = findBakedTexture(filePath, bakedData))
+        {
+            const BakedTextureLevel& level = bakedTexture->levels[0];
+            const char* levelData = bakedTexture->data + level.offset;
+            const vk::Extent2D extent { level.width, level.height };
+            info = { .width = level.width, .height = level.height };
+
+            if (bakedTexture->header->format == BakedTextureFormat::RGBA8Srgb)
+            {
+                region = spriteAtlas.addSprite(levelData, level.size, vk::Format::eR8G8B8A8Srgb, extent);
+            }
+            else if (textureLoader.bc1Supported)
+            {
+                region = spriteAtlas.addSprite(levelData, level.size, vk::Format::eBc1RgbaSrgbBlock, extent);
+            }
+            else
+            {
+                std::vector<uint8_t> rgba;
+                decodeBC1(reinterpret_cast<const uint8_t*>(levelData), level.width, level.height, rgba);
+                region = spriteAtlas.addSprite(reinterpret_cast<const char*>(rgba.data()), rgba.size(), vk::Format::eR8G8B8A8Srgb, extent);
+            }
+
+            if (!region)
+            {
+                region = TextureRegion { .textureIndex = static_cast<uint32_t>(textures.size()) };
+                textures.push_back(textureLoader.loadBakedTexture(*bakedTexture));
+            }
+        }
+
+        if (!region)
+        {
+            int width, height, components;
+            stbi_uc* textureData = stbi_load(filePath.c_str(), &width, &height, &components, 4);
+            if (!textureData)
+            {
+                throw std::runtime_error("Failed to load texture: " + filePath);
+            }
+
+            const vk::Extent2D extent { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+            info = { .width = extent.width, .height = extent.height };
+
+            region = spriteAtlas.addSprite(reinterpret_cast<const char*>(textureData), width * height * 4, vk::Format::eR8G8B8A8Srgb, extent);
+            if (!region)
+            {
+                region = TextureRegion { .textureIndex = static_cast<uint32_t>(textures.size()) };
+                textures.push_back(textureLoader.loadTexture(reinterpret_cast<const char*>(textureData), width * height * 4, vk::Format::eR8G8B8A8Srgb, extent));
+            }
+
+            stbi_image_free(textureData);
+        }
+
+        if (textureInfo)
+        {
+            *textureInfo = info;
+        }
+
+        return *region;
+    }
+
     uint32_t createGeometry(const GeometryDescription& description) override
     {
         uint32_t index = geometry.size();
@@ -602,18 +558,22 @@ class Application
     const SDLWindowSurfaceWrapper surface;
     const vk::SurfaceFormatKHR surfaceFormat;
     const vk::Format depthFormat;
+    const AssetPack assetPack;
     Audio audio;
     Swapchain swapchain;
     LoaderUtility loaderUtility;
     TextureLoader textureLoader;
     GeometryLoader geometryLoader;
     std::vector<Texture> textures;
+    std::vector<uint32_t> singleLevelTextures;
     std::vector<RenderGeometry> geometry;
+    SpriteAtlas spriteAtlas;
     ResourceLoader resourceLoader;
     Scene scene;
     InputManager inputManager;
     AppInterfaceProvider appInterface;
     InitShim<&GameLogicInterface::init> gameLogicInit;
+    InitShim<&SpriteAtlas::finalize> spriteAtlasFinalize;
     std::optional<std::pair<AllocatedBuffer, AllocatedBuffer>> geometryBuffers;
     InitShim<&LoaderUtility::commit> loaderUtilityCommit;
     const vk::Buffer geometryVertexBuffer;
@@ -641,15 +601,20 @@ public:
         surface(window, instance),
         surfaceFormat(getSurfaceFormat(physicalDevice, surface)),
         depthFormat(findDepthFormat(physicalDevice).value()),
+        assetPack("assets.pak"),
+        audio(assetPack, std::getenv("LD57_AUDIO_SINK")),
         swapchain(device, physicalDevice, surface, surfaceFormat, window.getFramebufferExtent()),
         loaderUtility(device, queue, queueFamilyIndex, *allocator),
-        textureLoader(device, *allocator, loaderUtility),
+        textureLoader(device, physicalDevice, *allocator, loaderUtility),
         geometryLoader(device, *allocator, loaderUtility),
         textures(),
+        singleLevelTextures(),
         geometry(),
-        resourceLoader(device, *allocator, textureLoader, geometryLoader, textures, geometry),
+        spriteAtlas(device, *allocator, loaderUtility, textures, singleLevelTextures),
+        resourceLoader(device, *allocator, textureLoader, geometryLoader, spriteAtlas, assetPack, textures, singleLevelTextures, geometry),
         appInterface(window),
         gameLogicInit(*gameLogic, resourceLoader, scene, inputManager, appInterface, audio),
+        spriteAtlasFinalize(spriteAtlas),
         geometryBuffers(geometry.empty()
                 ? std::nullopt
                 : std::optional{ geometryLoader.createGeometryVertexAndIndexBuffers() }),
@@ -657,9 +622,10 @@ public:
         geometryVertexBuffer(geometryBuffers ? *std::get<0>(geometryBuffers->first) : nullptr),
         geometryIndexBuffer(geometryBuffers ? *std::get<0>(geometryBuffers->second) : nullptr),
         renderer(device, queue, queueFamilyIndex, *allocator,
-                textures, geometryVertexBuffer, geometryIndexBuffer, 3,
+                textures, singleLevelTextures, geometryVertexBuffer, geometryIndexBuffer, 3,
                 surfaceFormat.format, depthFormat, window.getFramebufferExtent(),
-                physicalDevice.getProperties().limits.minUniformBufferOffsetAlignment),
+                physicalDevice.getProperties().limits.minUniformBufferOffsetAlignment,
+                physicalDevice.getFeatures().samplerAnisotropy ? physicalDevice.getProperties().limits.maxSamplerAnisotropy : 1.0f),
         loaderUtilityFinalize(loaderUtility),
         lastTime(SDL_GetTicksNS() * 1.e-9)
     {
@@ -731,10 +697,10 @@ public:
     {
         auto time = SDL_GetTicksNS() * 1.e-9;
         gameLogic->runFrame(scene, inputManager, appInterface, audio, time - lastTime);
+        // keeps a headless mixer in step with the game, the device drives itself
+        audio.advance(time - lastTime);
         lastTime = time;
 
-        audio.update();
-
         renderer.nextFrame();
         renderer.beginFrame();
         renderer.updateFrame(scene, geometry);
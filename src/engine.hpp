@@ -38,6 +38,14 @@ namespace eng
         std::vector<uint32_t> indices;
     };
 
+    // a rectangle of a texture, e.g. a sprite packed into an atlas page
+    struct TextureRegion
+    {
+        uint32_t textureIndex = 0;
+        glm::vec2 minTexCoord = { 0, 0 };
+        glm::vec2 texCoordScale = { 1, 1 };
+    };
+
     struct TextureInfo
     {
         uint32_t width = 0;
@@ -81,7 +89,11 @@ namespace eng
 
     struct ResourceLoaderInterface
     {
-        virtual uint32_t loadTexture(const std::string& filePath, TextureInfo* textureInfo = nullptr) = 0;
+        // pass mipmapped = false for textures packed with neighbouring cells (e.g. glyph sheets), those are
+        // sampled from the top level only so minification doesn't blend the cells together
+        virtual uint32_t loadTexture(const std::string& filePath, TextureInfo* textureInfo = nullptr, const bool mipmapped = true) = 0;
+        // small sprites are packed into shared atlas pages, use the region's tex coords when drawing
+        virtual TextureRegion loadSpriteTexture(const std::string& filePath, TextureInfo* textureInfo = nullptr) = 0;
         virtual uint32_t createGeometry(const GeometryDescription& description) = 0;
     };
 
@@ -140,10 +152,20 @@ namespace eng
 
     struct AudioInterface
     {
-        virtual uint32_t createLoop(const std::string& filePath) = 0;
-        virtual void destroyLoop(uint32_t index) = 0;
+        // decodes the file once, later calls with the same path return the cached handle.
+        // when all voices are busy, higher priority sounds steal voices from lower ones
+        virtual uint32_t loadSound(const std::string& filePath, const int32_t priority = 0) = 0;
+        // loops are streamed from disk, fading lets two loops crossfade
+        virtual uint32_t createLoop(const std::string& filePath, const float fadeInSeconds = 0.0f) = 0;
+        virtual void destroyLoop(uint32_t index, const float fadeOutSeconds = 0.0f) = 0;
         virtual uint32_t createSingleShot(const std::string& filePath) = 0;
+        virtual uint32_t createSingleShot(const uint32_t sound) = 0;
+        // positional single shots are attenuated by their distance to the listener and panned across its right axis,
+        // sounds out of audible range aren't played at all
+        virtual uint32_t createSingleShot(const uint32_t sound, const glm::vec3& position) = 0;
         virtual void destroySingleShot(uint32_t index) = 0;
+        virtual void setGain(uint32_t index, const float gain) = 0;
+        virtual void setListener(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& up = glm::vec3(0, 1, 0)) = 0;
         virtual void setMuted(const bool value) = 0;
     };
 
@@ -1,8 +1,12 @@
 #include "engine.hpp"
 #include "physics.hpp"
+#include "body_registry.hpp"
 #include "dungeon.hpp"
 #include "jph_glm_convert.hpp"
+#include "mesh_optimizer.hpp"
+#include "projectiles.hpp"
 
+#include <array>
 #include <iostream>
 #include <numeric>
 #include <memory>
@@ -20,6 +24,7 @@
 #include <SDL3/SDL_mouse.h>
 
 #include <Jolt/Jolt.h>
+#include <Jolt/Core/JobSystem.h>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
 #include <Jolt/Physics/Character/Character.h>
 #include <Jolt/Physics/Character/CharacterVirtual.h>
@@ -28,7 +33,6 @@
 #include <Jolt/Physics/Collision/Shape/BoxShape.h>
 #include <Jolt/Physics/Collision/Shape/CapsuleShape.h>
 #include <Jolt/Physics/Collision/Shape/ConvexHullShape.h>
-#include <Jolt/Physics/Collision/Shape/SphereShape.h>
 #include <Jolt/Physics/PhysicsSystem.h>
 
 static std::vector<uint32_t> getIndexedTextures(eng::ResourceLoaderInterface& resourceLoader, const std::format_string<uint32_t>& basePath, uint32_t firstIndex, uint32_t count)
@@ -42,6 +46,17 @@ static std::vector<uint32_t> getIndexedTextures(eng::ResourceLoaderInterface& re
     return values;
 }
 
+static std::vector<eng::TextureRegion> getIndexedSpriteTextures(eng::ResourceLoaderInterface& resourceLoader, const std::format_string<uint32_t>& basePath, uint32_t firstIndex, uint32_t count)
+{
+    std::vector<eng::TextureRegion> values;
+    values.reserve(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        values.push_back(resourceLoader.loadSpriteTexture(std::format(basePath, firstIndex + i)));
+    }
+    return values;
+}
+
 static void drawText(eng::SceneLayer& layer, const glm::vec2& fontTexCoordScale, const uint32_t fontTexture, const std::string& text, const glm::vec2& position, const float scale, const glm::vec4& background, const glm::vec4& foreground, bool centered)
 {
     const float fontAspect = fontTexCoordScale.x / fontTexCoordScale.y;
@@ -97,6 +112,21 @@ struct Enemy
     int animationState = EnemyAnimationStates::Walk;
     uint32_t animationOffset = 0;
     bool loopAnimation = true;
+    // last room the enemy was seen in, its body is deactivated and it doesn't think while asleep
+    uint32_t room = UINT32_MAX;
+    bool asleep = false;
+};
+
+// what owns a body, index into the owner's container
+struct BodyEntity
+{
+    enum class Type
+    {
+        Level, Enemy,
+    };
+
+    Type type;
+    uint32_t index;
 };
 
 namespace PlayerStates
@@ -116,13 +146,6 @@ namespace PlayerStates
     };
 };
 
-struct Bullet
-{
-    JPH::BodyID bodyID;
-    float angle;
-    bool friendly;
-};
-
 struct CooldownTrigger
 {
     std::vector<uint32_t> inputs;
@@ -177,20 +200,30 @@ struct GameCommon
         std::vector<uint32_t> wall;
         std::vector<uint32_t> obstacle;
         std::vector<uint32_t> obstacleTop;
-        std::vector<uint32_t> bullet;
-        std::vector<uint32_t> spiderBullet;
+        std::vector<eng::TextureRegion> bullet;
+        std::vector<eng::TextureRegion> spiderBullet;
         uint32_t splat;
         uint32_t spiderweb;
         uint32_t font;
-        std::vector<uint32_t> player[PlayerStates::MAX_VALUE];
-        std::vector<uint32_t> spider[EnemyAnimationStates::MAX_VALUE];
-        std::vector<uint32_t> hole;
-        std::vector<uint32_t> muzzleFlash;
-        std::vector<uint32_t> dazed;
-        std::vector<uint32_t> dead;
-        uint32_t hitpoint;
+        std::vector<eng::TextureRegion> player[PlayerStates::MAX_VALUE];
+        std::vector<eng::TextureRegion> spider[EnemyAnimationStates::MAX_VALUE];
+        std::vector<eng::TextureRegion> hole;
+        std::vector<eng::TextureRegion> muzzleFlash;
+        std::vector<eng::TextureRegion> dazed;
+        std::vector<eng::TextureRegion> dead;
+        eng::TextureRegion hitpoint;
     } textures;
 
+    struct {
+        uint32_t characterHit;
+        uint32_t slide;
+        uint32_t shot;
+        uint32_t gameOver;
+        uint32_t attack;
+        uint32_t spiderAttack;
+        uint32_t spiderDeath;
+    } sounds;
+
     struct {
         uint32_t left;
         uint32_t right;
@@ -210,9 +243,12 @@ struct GameCommon
 
     std::vector<Dungeon> dungeons;
     std::vector<std::vector<std::pair<uint32_t, uint32_t>>> dungeonGeometryResourcePairs;
+    // shared by every dungeon's physics world
+    const std::unique_ptr<JPH::JobSystem> jobSystem;
     const glm::vec2 fontTexCoordScale = { 1.0f / 16.0f, 1.0f / 8.0f };
 
-    GameCommon(eng::ResourceLoaderInterface& resourceLoader, eng::InputInterface& input)
+    GameCommon(eng::ResourceLoaderInterface& resourceLoader, eng::InputInterface& input, eng::AudioInterface& audio) :
+        jobSystem(fff::createJobSystem())
     {
         textures = {
             .blank = resourceLoader.loadTexture("resources/textures/blank.png"),
@@ -221,36 +257,46 @@ struct GameCommon
             .wall = getIndexedTextures(resourceLoader, "resources/textures/wall/Wall{:}.png", 1, numDungeons),
             .obstacle = getIndexedTextures(resourceLoader, "resources/textures/obstacle/Obstacle{:}.png", 1, numDungeons),
             .obstacleTop = getIndexedTextures(resourceLoader, "resources/textures/obstacleTop/Obstacle{:}.png", 1, numDungeons),
-            .bullet = getIndexedTextures(resourceLoader, "resources/textures/pc_projectile/PCProjectile{:}.png", 1, 2),
-            .spiderBullet = getIndexedTextures(resourceLoader, "resources/textures/spider/SpiderProjectile{:}.png", 2, 2),
+            .bullet = getIndexedSpriteTextures(resourceLoader, "resources/textures/pc_projectile/PCProjectile{:}.png", 1, 2),
+            .spiderBullet = getIndexedSpriteTextures(resourceLoader, "resources/textures/spider/SpiderProjectile{:}.png", 2, 2),
             .splat = resourceLoader.loadTexture("resources/textures/Goop2.png"),
             .spiderweb = resourceLoader.loadTexture("resources/textures/Spiderweb.png"),
-            .font = resourceLoader.loadTexture("resources/textures/font.png"),
-            .hole = getIndexedTextures(resourceLoader, "resources/textures/hole/FloorFallingThruAnim{:}.png", 1, 8),
-            .muzzleFlash = getIndexedTextures(resourceLoader, "resources/textures/muzzleflash/PCMuzzleFlash{:}.png", 1, 2),
-            .dazed = getIndexedTextures(resourceLoader, "resources/textures/dazed/DazedAnim{:}.png", 1, 3),
-            .dead = getIndexedTextures(resourceLoader, "resources/textures/death/DeathAnimation{:}.png", 1, 5),
-            .hitpoint = resourceLoader.loadTexture("resources/textures/hitpoint.png"),
+            .font = resourceLoader.loadTexture("resources/textures/font.png", nullptr, false),
+            .hole = getIndexedSpriteTextures(resourceLoader, "resources/textures/hole/FloorFallingThruAnim{:}.png", 1, 8),
+            .muzzleFlash = getIndexedSpriteTextures(resourceLoader, "resources/textures/muzzleflash/PCMuzzleFlash{:}.png", 1, 2),
+            .dazed = getIndexedSpriteTextures(resourceLoader, "resources/textures/dazed/DazedAnim{:}.png", 1, 3),
+            .dead = getIndexedSpriteTextures(resourceLoader, "resources/textures/death/DeathAnimation{:}.png", 1, 5),
+            .hitpoint = resourceLoader.loadSpriteTexture("resources/textures/hitpoint.png"),
+        };
+
+        sounds = {
+            .characterHit = audio.loadSound("resources/audio/characterhit.wav", 3),
+            .slide = audio.loadSound("resources/audio/XTerminatorSlideSound.wav", 2),
+            .shot = audio.loadSound("resources/audio/shotfx.wav", 2),
+            .gameOver = audio.loadSound("resources/audio/Gameoverfx.wav", 4),
+            .attack = audio.loadSound("resources/audio/attacksound.wav", 1),
+            .spiderAttack = audio.loadSound("resources/audio/spiderattackfx.wav"),
+            .spiderDeath = audio.loadSound("resources/audio/spiderdeath.wav"),
         };
 
         for (uint32_t i = 0; i < PlayerStates::MAX_VALUE; ++i)
         {
             switch (i)
             {
-                case PlayerStates::Idle: textures.player[i] = { resourceLoader.loadTexture("resources/textures/player/PCWalk2.png") }; break;
-                case PlayerStates::Walk: textures.player[i] = getIndexedTextures(resourceLoader, "resources/textures/player/PCWalk{:}.png", 1, 4); break;
-                case PlayerStates::Slide: textures.player[i] = { resourceLoader.loadTexture("resources/textures/player/PCSlide.png") }; break;
-                case PlayerStates::Damaged: textures.player[i] = getIndexedTextures(resourceLoader, "resources/textures/player/PCDamageFrames{:}.png", 1, 2); break;
-                case PlayerStates::Shooting: textures.player[i] = { resourceLoader.loadTexture("resources/textures/player/PCShooting.png") }; break;
+                case PlayerStates::Idle: textures.player[i] = { resourceLoader.loadSpriteTexture("resources/textures/player/PCWalk2.png") }; break;
+                case PlayerStates::Walk: textures.player[i] = getIndexedSpriteTextures(resourceLoader, "resources/textures/player/PCWalk{:}.png", 1, 4); break;
+                case PlayerStates::Slide: textures.player[i] = { resourceLoader.loadSpriteTexture("resources/textures/player/PCSlide.png") }; break;
+                case PlayerStates::Damaged: textures.player[i] = getIndexedSpriteTextures(resourceLoader, "resources/textures/player/PCDamageFrames{:}.png", 1, 2); break;
+                case PlayerStates::Shooting: textures.player[i] = { resourceLoader.loadSpriteTexture("resources/textures/player/PCShooting.png") }; break;
                 default: break;
             }
         }
         textures.player[PlayerStates::FallingInHole] = textures.player[PlayerStates::Idle];
         textures.player[PlayerStates::Dazed] = textures.player[PlayerStates::Slide];
 
-        textures.spider[EnemyAnimationStates::Walk] = getIndexedTextures(resourceLoader, "resources/textures/spider/SpiderEnemyWalk{:}.png", 2, 3);
-        textures.spider[EnemyAnimationStates::Shooting] = getIndexedTextures(resourceLoader, "resources/textures/spider/SpiderShooting{:}.png", 1, 3);
-        textures.spider[EnemyAnimationStates::Damage] = getIndexedTextures(resourceLoader, "resources/textures/spider/SpiderDamage{:}.png", 1, 2);
+        textures.spider[EnemyAnimationStates::Walk] = getIndexedSpriteTextures(resourceLoader, "resources/textures/spider/SpiderEnemyWalk{:}.png", 2, 3);
+        textures.spider[EnemyAnimationStates::Shooting] = getIndexedSpriteTextures(resourceLoader, "resources/textures/spider/SpiderShooting{:}.png", 1, 3);
+        textures.spider[EnemyAnimationStates::Damage] = getIndexedSpriteTextures(resourceLoader, "resources/textures/spider/SpiderDamage{:}.png", 1, 2);
 
         inputMappings = {
             .left = input.mapKey(input.createMapping(), SDL_GetScancodeFromKey(SDLK_A, nullptr)),
@@ -274,28 +320,59 @@ struct GameCommon
             },
         };
 
-        dungeons.reserve(numDungeons);
+        // levels only depend on their parameters, generate and optimize them all at once on the physics workers
+        // and only upload the geometry from here after
+        const uint64_t seed = static_cast<uint64_t>(time(0));
+        dungeons.resize(numDungeons);
+        std::vector<Dungeon::Geometry> geometries(numDungeons);
+        // floor, walls, obstacle sides and tops of each level
+        std::vector<std::array<eng::MeshOptimizationStats, 4>> optimizationStats(numDungeons);
+        JPH::JobSystem::Barrier* barrier = jobSystem->CreateBarrier();
+        for (int i = 0; i < numDungeons; ++i)
+        {
+            barrier->AddJob(jobSystem->CreateJob("GenerateDungeon", JPH::Color::sCyan, [this, &geometries, &optimizationStats, seed, i] {
+                    dungeons[i] = Dungeon::generate(Dungeon::GenerationParams {
+                                .seed = seed,
+                                .width = static_cast<uint32_t>(30 + 20 * i),
+                                .height = static_cast<uint32_t>(30 + 20 * i),
+                                .partitionedRoomCount = static_cast<uint32_t>(20 + 40 * i),
+                                .targetRoomCount = static_cast<uint32_t>(6 + 4 * i),
+                                .minSplitDimension = 6,
+                                .minPortalOverlap = 2,
+                            });
+                    auto& geometry = geometries[i];
+                    geometry = dungeons[i].createGeometry(3, 1.0f, 0.5f, 2, 1);
+                    eng::GeometryDescription* parts[] = { &geometry.floor, &geometry.walls, &geometry.obstacleSides, &geometry.obstacleTops };
+                    for (uint32_t part = 0; part < optimizationStats[i].size(); ++part)
+                    {
+                        *parts[part] = eng::optimizeGeometry(*parts[part], &optimizationStats[i][part]);
+                    }
+                }));
+        }
+        jobSystem->WaitForJobs(barrier);
+        jobSystem->DestroyBarrier(barrier);
+
         dungeonGeometryResourcePairs.reserve(numDungeons);
         for (int i = 0; i < numDungeons; ++i)
         {
-            auto dungeon = Dungeon::generate(Dungeon::GenerationParams {
-                        .seed = static_cast<uint64_t>(time(0)),
-                        .width = static_cast<uint32_t>(30 + 20 * i),
-                        .height = static_cast<uint32_t>(30 + 20 * i),
-                        .partitionedRoomCount = static_cast<uint32_t>(20 + 40 * i),
-                        .targetRoomCount = static_cast<uint32_t>(6 + 4 * i),
-                        .minSplitDimension = 6,
-                        .minPortalOverlap = 2,
-                    });
-            auto geometry = dungeon.createGeometry(3, 1.0f, 0.5f, 2, 1);
+            const auto& geometry = geometries[i];
             dungeonGeometryResourcePairs.push_back({
                     { textures.floor[i], resourceLoader.createGeometry(geometry.floor) },
                     { textures.wall[i], resourceLoader.createGeometry(geometry.walls) },
                     { textures.obstacle[i], resourceLoader.createGeometry(geometry.obstacleSides) },
                     { textures.obstacleTop[i], resourceLoader.createGeometry(geometry.obstacleTops) },
                 });
-            std::cout << dungeon.rooms.size() << " " << dungeon.spawnPoints.size() << std::endl;
-            dungeons.push_back(std::move(dungeon));
+            std::cout << dungeons[i].rooms.size() << " " << dungeons[i].spawnPoints.size() << std::endl;
+
+            const char* partNames[] = { "floor", "walls", "obstacle sides", "obstacle tops" };
+            for (uint32_t part = 0; part < optimizationStats[i].size(); ++part)
+            {
+                const auto& stats = optimizationStats[i][part];
+                std::cout << "Optimized dungeon " << i << " " << partNames[part] << ": "
+                    << stats.vertexCountBefore << " -> " << stats.vertexCountAfter << " vertices, "
+                    << stats.triangleCountBefore << " -> " << stats.triangleCountAfter << " triangles, ACMR "
+                    << stats.acmrBefore << " -> " << stats.acmrAfter << std::endl;
+            }
         }
     }
 };
@@ -314,6 +391,10 @@ struct GameSceneRunner : public JPH::CharacterContactListener
     const glm::vec3 bulletOrigin = glm::vec3(0.0625, 0, -0.5);
     const float bulletSpeed = 20.0f;
     const float bulletRadius = 0.05f;
+    // bullets drop to the floor long before this, it only catches ones that fall out of the level
+    const float bulletLifetime = 5.0f;
+    const uint32_t maxBullets = 256;
+    const glm::vec3 characterHalfExtent = glm::vec3(0.2f, 0.6f, 0.2f);
     const int playerMaxHealth = 10;
     const float slideTime = 3.0f;
     const float shootTime = 2.0f;
@@ -329,18 +410,34 @@ struct GameSceneRunner : public JPH::CharacterContactListener
 
     std::vector<JPH::Ref<JPH::Shape>> shapeRefs;
     JPH::Ref<JPH::CharacterVirtual> playerCharacter;
-    JPH::Ref<JPH::Shape> bulletShape;
     JPH::Ref<JPH::Shape> characterShape;
 
     std::vector<Enemy> enemies;
+    fff::BodyRegistry<BodyEntity> bodyEntities;
+    Dungeon::RoomMap roomMap;
+    // the player's room and its neighbours, enemies anywhere else sleep while idle
+    uint32_t playerRoom = UINT32_MAX;
+    std::vector<bool> activeRooms;
     std::vector<eng::Decal> decals;
-    std::vector<Bullet> bullets;
+    // flags bullets carry, the player is a target for hostile ones
+    static constexpr uint32_t FRIENDLY_BULLET = 1;
+    static constexpr uint32_t HOSTILE_BULLET = 2;
+    fff::Projectiles bullets;
+    std::vector<fff::Projectiles::Hit> bulletHits;
     std::vector<std::pair<glm::vec3, uint32_t>> deathParticles;
 
+    std::vector<fff::RayQuery> sightlineRays;
+    std::vector<fff::RayHit> sightlineHits;
+    // per enemy, into sightlineHits
+    std::vector<uint32_t> sightlineIndices;
+
     uint32_t animationCounter = 0;
     double animationTimer = 0;
 
     glm::vec3 cameraPosition = { 0, 2, 0 };
+    // the player between its last two physics steps
+    glm::vec3 previousPlayerPosition = glm::vec3(0);
+    glm::vec3 playerRenderPosition = glm::vec3(0);
     float playerAngle = 0;
     PlayerStates::PlayerStates playerState = PlayerStates::Dazed;
     PlayerStates::PlayerStates lastPlayerState = PlayerStates::MAX_VALUE;
@@ -366,11 +463,13 @@ struct GameSceneRunner : public JPH::CharacterContactListener
 
     GameSceneRunner(const GameCommon& common, uint32_t dungeonIndex) :
         common(common),
-        dungeonIndex(dungeonIndex)
+        dungeonIndex(dungeonIndex),
+        bullets(maxBullets, bulletRadius, bulletLifetime)
     {
-        physicsWorld.reset(fff::createPhysicsWorld());
-        physicsWorld->setOnCollisionEnter([this](const JPH::BodyID body0, const JPH::BodyID body1) {
-                onCollisionEnter(body0, body1);
+        physicsWorld.reset(fff::createPhysicsWorld(*common.jobSystem));
+        physicsWorld->setOnStep([this](const float stepTime) {
+                stepCharacters(stepTime);
+                stepBullets(stepTime);
             });
 
         shootTrigger.cooldown = shootCooldown;
@@ -381,7 +480,14 @@ struct GameSceneRunner : public JPH::CharacterContactListener
 
         const auto& dungeon = common.dungeons[dungeonIndex];
         std::vector<JPH::BodyID> mapBodies;
-        dungeon.createPhysicsBodies(2, 1, 0.5, mapBodies, shapeRefs, physicsWorld->getPhysicsSystem());
+        dungeon.createPhysicsBodies(2, 1, 0.5, mapBodies, shapeRefs, physicsWorld->getPhysicsSystem(), Dungeon::CollisionLayout::CompoundPerRoom);
+        for (uint32_t i = 0; i < mapBodies.size(); ++i)
+        {
+            bodyEntities.set(mapBodies[i], BodyEntity { BodyEntity::Type::Level, i });
+        }
+
+        roomMap = dungeon.createRoomMap();
+        activeRooms.assign(dungeon.rooms.size(), false);
 
         glm::vec3 playerStartPosition(dungeon.playerSpawn.first + 0.5, 1, dungeon.playerSpawn.second + 0.5);
 
@@ -401,9 +507,10 @@ struct GameSceneRunner : public JPH::CharacterContactListener
                         .character = new JPH::Character(&characterSettings, glm_to_jph(position), JPH::Quat::sIdentity(), 0, &physicsWorld->getPhysicsSystem()),
                     });
             enemies.back().character->AddToPhysicsSystem();
+            bodyEntities.set(enemies.back().character->GetBodyID(), BodyEntity { BodyEntity::Type::Enemy, static_cast<uint32_t>(enemies.size() - 1) });
         }
 
-        characterShape = shapeRefs.emplace_back(new JPH::BoxShape(JPH::Vec3(0.2f, 0.6f, 0.2f)));
+        characterShape = shapeRefs.emplace_back(new JPH::BoxShape(glm_to_jph(characterHalfExtent)));
 
         JPH::CharacterVirtualSettings characterSettings;
         characterSettings.mShape = characterShape;
@@ -412,8 +519,12 @@ struct GameSceneRunner : public JPH::CharacterContactListener
         playerCharacter = new JPH::CharacterVirtual(&characterSettings,
                 glm_to_jph(playerStartPosition), JPH::Quat::sIdentity(), &physicsWorld->getPhysicsSystem());
         playerCharacter->SetListener(this);
+        previousPlayerPosition = playerRenderPosition = playerStartPosition;
+        updateSimulationLod();
 
-        bulletShape = shapeRefs.emplace_back(new JPH::SphereShape(bulletRadius));
+
+        // everything static is in, rebuild the broadphase tree once instead of letting the first steps run on the insertion order
+        physicsWorld->getPhysicsSystem().OptimizeBroadPhase();
     }
 
     ~GameSceneRunner()
@@ -423,6 +534,7 @@ struct GameSceneRunner : public JPH::CharacterContactListener
             enemy.character->RemoveFromPhysicsSystem();
         }
         enemies.clear();
+        bodyEntities.clear();
         playerCharacter = nullptr;
         shapeRefs.clear();
         physicsWorld.reset();
@@ -450,67 +562,103 @@ struct GameSceneRunner : public JPH::CharacterContactListener
     void OnContactAdded(const JPH::CharacterVirtual* character, const JPH::BodyID& bodyID1, const JPH::SubShapeID& subShapeID1,
             const JPH::RVec3Arg contactPosition, const JPH::Vec3Arg contactNormal, JPH::CharacterContactSettings& ioSettings) override
     {
-        if (auto bulletIter = std::find_if(bullets.begin(), bullets.end(),
-                    [bodyID1](const auto& bullet) { return bullet.bodyID == bodyID1; });
-                bulletIter != bullets.end())
+        if (character == playerCharacter && playerState == PlayerStates::Slide)
         {
-            physicsWorld->getPhysicsSystem().GetBodyInterface().RemoveBody(bodyID1);
-            physicsWorld->getPhysicsSystem().GetBodyInterface().DestroyBody(bodyID1);
-            bullets.erase(bulletIter);
+            if (const auto entity = bodyEntities.find(bodyID1); entity && entity->type == BodyEntity::Type::Enemy)
+            {
+                enemies[entity->index].state = Enemy::State::Damaged;
+                ioSettings.mCanPushCharacter = false;
+            }
+        }
+    }
+
+    void updateSimulationLod()
+    {
+        const auto& dungeon = common.dungeons[dungeonIndex];
 
-            if (character == playerCharacter)
+        const glm::vec3 playerPosition = jph_to_glm(playerCharacter->GetPosition());
+        if (const uint32_t room = roomMap.find(playerPosition.x, playerPosition.z); room != UINT32_MAX && room != playerRoom)
+        {
+            playerRoom = room;
+            std::fill(activeRooms.begin(), activeRooms.end(), false);
+            activeRooms[room] = true;
+            for (uint32_t i = dungeon.rooms[room].portalRecordsRange.start; i < dungeon.rooms[room].portalRecordsRange.end; ++i)
             {
-                if (playerState == PlayerStates::Slide)
+                activeRooms[dungeon.roomPortalRecords[i].rooms[1]] = true;
+            }
+        }
+
+        auto& bodyInterface = physicsWorld->getPhysicsSystem().GetBodyInterface();
+        for (auto& enemy : enemies)
+        {
+            if (enemy.lastState == Enemy::State::Dead)
+            {
+                continue;
+            }
+
+            if (!enemy.asleep)
+            {
+                const glm::vec3 position = jph_to_glm(enemy.character->GetPosition());
+                if (const uint32_t room = roomMap.find(position.x, position.z); room != UINT32_MAX)
                 {
-                    ioSettings.mCanPushCharacter = false;
+                    enemy.room = room;
+                }
+            }
+
+            // anything besides wandering around is a reaction to the player, which keeps it awake
+            const bool awake = enemy.state != Enemy::State::Idle || enemy.room == UINT32_MAX || activeRooms[enemy.room];
+            if (awake == enemy.asleep)
+            {
+                if (awake)
+                {
+                    bodyInterface.ActivateBody(enemy.character->GetBodyID());
                 }
                 else
                 {
-                    playerState = PlayerStates::Damaged;
+                    bodyInterface.DeactivateBody(enemy.character->GetBodyID());
                 }
-            }
-        }
-        else if (character == playerCharacter && playerState == PlayerStates::Slide)
-        {
-            if (auto enemyIter = std::find_if(enemies.begin(), enemies.end(),
-                        [bodyID1](const auto& enemy) { return enemy.character->GetBodyID() == bodyID1; });
-                    enemyIter != enemies.end())
-            {
-                enemyIter->state = Enemy::State::Damaged;
-                ioSettings.mCanPushCharacter = false;
+                enemy.asleep = !awake;
             }
         }
     }
 
-    // generic bodies
-    void onCollisionEnter(const JPH::BodyID body0, const JPH::BodyID body1)
+    void stepBullets(const float stepTime)
     {
-        if (auto bulletIter = std::find_if(bullets.begin(), bullets.end(),
-                    [body0](const auto& bullet) { return bullet.bodyID == body0; });
-                bulletIter != bullets.end())
-        {
-            const bool friendly = bulletIter->friendly;
-            physicsWorld->getPhysicsSystem().GetBodyInterface().RemoveBody(body0);
-            physicsWorld->getPhysicsSystem().GetBodyInterface().DestroyBody(body0);
-            bullets.erase(bulletIter);
+        const glm::vec3 playerPosition = jph_to_glm(playerCharacter->GetPosition());
+        const glm::vec3 playerHalfExtent = characterHalfExtent + glm::vec3(bulletRadius);
+        const fff::Projectiles::Target targets[] = {
+            { playerPosition - playerHalfExtent, playerPosition + playerHalfExtent, HOSTILE_BULLET },
+        };
+
+        // static and character layers
+        bulletHits.clear();
+        bullets.step(*physicsWorld, stepTime, 0b11, targets, bulletHits);
 
-            if (physicsWorld->getPhysicsSystem().GetBodyInterface().GetObjectLayer(body1) == 0)
+        for (const auto& hit : bulletHits)
+        {
+            if (hit.target != fff::Projectiles::NO_TARGET)
             {
-                const auto [ idPair, contact ] = physicsWorld->getContacts(body0, body1).front();
-                bool first = idPair.GetBody1ID() == body0;
-
-                decals.push_back(eng::Decal {
-                        .position = jph_to_glm(first ? contact.GetWorldSpaceContactPointOn2(0) : contact.GetWorldSpaceContactPointOn1(0)),
-                        .scale = glm::vec3(1, 1, 0.05),
-                        .rotation = glm::rotation(glm::vec3(0, 0, -1), jph_to_glm(contact.mWorldSpaceNormal)) * glm::angleAxis(glm::linearRand(0.0f, glm::pi<float>()), glm::vec3(0, 0, 1)),
-                        .textureIndex = friendly? common.textures.splat : common.textures.spiderweb,
-                    });
+                if (playerState != PlayerStates::Slide)
+                {
+                    playerState = PlayerStates::Damaged;
+                }
             }
-            else if (auto enemyIter = std::find_if(enemies.begin(), enemies.end(),
-                        [body1](const auto& enemy) { return enemy.character->GetBodyID() == body1; });
-                    enemyIter != enemies.end())
+            else if (const auto entity = bodyEntities.find(JPH::BodyID(hit.body)))
             {
-                enemyIter->state = Enemy::State::Damaged;
+                switch (entity->type)
+                {
+                    case BodyEntity::Type::Level:
+                        decals.push_back(eng::Decal {
+                                .position = hit.position,
+                                .scale = glm::vec3(1, 1, 0.05),
+                                .rotation = glm::rotation(glm::vec3(0, 0, -1), hit.normal) * glm::angleAxis(glm::linearRand(0.0f, glm::pi<float>()), glm::vec3(0, 0, 1)),
+                                .textureIndex = (hit.flags & FRIENDLY_BULLET) ? common.textures.splat : common.textures.spiderweb,
+                            });
+                        break;
+                    case BodyEntity::Type::Enemy:
+                        enemies[entity->index].state = Enemy::State::Damaged;
+                        break;
+                }
             }
         }
     }
@@ -548,11 +696,11 @@ struct GameSceneRunner : public JPH::CharacterContactListener
             if (playerState == PlayerStates::Damaged)
             {
                 playerHealth --;
-                audio.createSingleShot("resources/audio/characterhit.wav");
+                audio.createSingleShot(common.sounds.characterHit);
             }
             else if (playerState == PlayerStates::Slide)
             {
-                audio.createSingleShot("resources/audio/XTerminatorSlideSound.wav");
+                audio.createSingleShot(common.sounds.slide);
                 glm::vec2 moveInput(0, -1);
                 if (glm::any(glm::greaterThan(glm::abs(keyboardMoveInput), glm::vec2(0))))
                 {
@@ -581,21 +729,14 @@ struct GameSceneRunner : public JPH::CharacterContactListener
             }
             else if (playerState == PlayerStates::Shooting)
             {
-                audio.createSingleShot("resources/audio/shotfx.wav");
-                auto& bullet = bullets.emplace_back(
-                        physicsWorld->getPhysicsSystem().GetBodyInterface().CreateAndAddBody(
-                            JPH::BodyCreationSettings(bulletShape,
-                                playerCharacter->GetPosition() + glm_to_jph(glm::angleAxis(playerAngle, glm::vec3(0, 1, 0)) * bulletOrigin),
-                                JPH::Quat::sIdentity(),
-                                JPH::EMotionType::Dynamic, 1),
-                            JPH::EActivation::Activate),
-                        playerAngle, true);
-                physicsWorld->getPhysicsSystem().GetBodyInterface().SetLinearVelocity(bullet.bodyID,
-                        glm_to_jph(glm::angleAxis(playerAngle, glm::vec3(0, 1, 0)) * glm::vec3(0, 0, -1) * bulletSpeed));
+                audio.createSingleShot(common.sounds.shot);
+                const glm::quat rotation = glm::angleAxis(playerAngle, glm::vec3(0, 1, 0));
+                bullets.spawn(jph_to_glm(playerCharacter->GetPosition()) + rotation * bulletOrigin,
+                        rotation * glm::vec3(0, 0, -1) * bulletSpeed, playerAngle, FRIENDLY_BULLET);
             }
             else if (playerState == PlayerStates::Dead)
             {
-                audio.createSingleShot("resources/audio/Gameoverfx.wav");
+                audio.createSingleShot(common.sounds.gameOver);
                 state = State::GameOver;
                 return;
             }
@@ -720,34 +861,59 @@ struct GameSceneRunner : public JPH::CharacterContactListener
 
         playerStateTimer += deltaTime;
 
-        for (auto& enemy : enemies)
+        updateSimulationLod();
+
+        // sightlines for every enemy that may check one this frame, cast in one batch
+        sightlineRays.clear();
+        sightlineIndices.assign(enemies.size(), UINT32_MAX);
+        for (uint32_t i = 0; i < enemies.size(); ++i)
         {
+            const auto& enemy = enemies[i];
+            if (enemy.asleep)
+            {
+                continue;
+            }
+            if (enemy.state == Enemy::State::Targeting || enemy.character->GetPosition().IsClose(playerCharacter->GetPosition(), 2.0f))
+            {
+                sightlineIndices[i] = sightlineRays.size();
+                sightlineRays.push_back(fff::RayQuery {
+                        .origin = jph_to_glm(enemy.character->GetPosition()),
+                        .direction = jph_to_glm(playerCharacter->GetPosition() - enemy.character->GetPosition()),
+                    });
+            }
+        }
+        sightlineHits.resize(sightlineRays.size());
+        physicsWorld->castRays(sightlineRays, sightlineHits);
+
+        for (uint32_t enemyIndex = 0; enemyIndex < enemies.size(); ++enemyIndex)
+        {
+            auto& enemy = enemies[enemyIndex];
+            if (enemy.asleep)
+            {
+                continue;
+            }
             enemy.position = jph_to_glm(enemy.character->GetPosition());
 
             const auto findPoi = [&]() {
                 const float maxDistance = glm::linearRand(1.0f, 5.0f);
                 const glm::vec2 dir = glm::circularRand(maxDistance);
-                enemy.poi = jph_to_glm(enemy.character->GetPosition()) + glm::vec3(dir.x, 0, dir.y);
-                const JPH::RRayCast raycast(enemy.character->GetPosition(), JPH::Vec3(dir.x, 0, dir.y));
-                JPH::RayCastResult raycastResult;
-                if (physicsWorld->getPhysicsSystem().GetNarrowPhaseQuery().CastRay(raycast, raycastResult, JPH::SpecifiedBroadPhaseLayerFilter(JPH::BroadPhaseLayer(0))))
-                {
-                    JPH::BodyLockRead lock(physicsWorld->getPhysicsSystem().GetBodyLockInterface(), raycastResult.mBodyID);
-                    if (lock.Succeeded())
-                    {
-                        enemy.poi = jph_to_glm(raycast.GetPointOnRay(glm::max(0.0f, raycastResult.mFraction - 0.1f / maxDistance)));
-                    }
-                }
+                const fff::RayQuery ray {
+                    .origin = jph_to_glm(enemy.character->GetPosition()),
+                    .direction = glm::vec3(dir.x, 0, dir.y),
+                };
+                const fff::RayHit hit = physicsWorld->castRay(ray);
+                enemy.poi = ray.origin + glm::max(0.0f, hit.hit ? hit.fraction - 0.1f / maxDistance : 1.0f) * ray.direction;
             };
 
             const auto sightlineToPlayer = [&]() {
-                const JPH::RRayCast raycast(enemy.character->GetPosition(), playerCharacter->GetPosition() - enemy.character->GetPosition());
-                JPH::RayCastResult raycastResult;
-                if (physicsWorld->getPhysicsSystem().GetNarrowPhaseQuery().CastRay(raycast, raycastResult, JPH::SpecifiedBroadPhaseLayerFilter(JPH::BroadPhaseLayer(0))))
+                if (sightlineIndices[enemyIndex] != UINT32_MAX)
                 {
-                    return false;
+                    return !sightlineHits[sightlineIndices[enemyIndex]].hit;
                 }
-                return true;
+                return !physicsWorld->castRay(fff::RayQuery {
+                        .origin = jph_to_glm(enemy.character->GetPosition()),
+                        .direction = jph_to_glm(playerCharacter->GetPosition() - enemy.character->GetPosition()),
+                    }).hit;
             };
 
             if (enemy.state != enemy.lastState)
@@ -758,7 +924,7 @@ struct GameSceneRunner : public JPH::CharacterContactListener
                 }
                 else if (enemy.state == Enemy::State::Damaged)
                 {
-                    audio.createSingleShot("resources/audio/attacksound.wav");
+                    audio.createSingleShot(common.sounds.attack, enemy.position);
 
                     const glm::vec3 deltaPos = enemy.position - cameraPosition;
                     const glm::vec3 deltaHPos = glm::vec3(deltaPos.x, 0, deltaPos.z);
@@ -793,20 +959,14 @@ struct GameSceneRunner : public JPH::CharacterContactListener
                 }
                 else if (enemy.state == Enemy::State::Firing)
                 {
-                    audio.createSingleShot("resources/audio/spiderattackfx.wav");
-                    auto& bullet = bullets.emplace_back(
-                            physicsWorld->getPhysicsSystem().GetBodyInterface().CreateAndAddBody(
-                                JPH::BodyCreationSettings(bulletShape,
-                                    enemy.character->GetPosition() + glm_to_jph(glm::angleAxis(enemy.angle, glm::vec3(0, 1, 0)) * glm::vec3(0, 0, -0.5)),
-                                    JPH::Quat::sIdentity(),
-                                    JPH::EMotionType::Dynamic, 1),
-                                JPH::EActivation::Activate),
-                            enemy.angle, false);
-                    physicsWorld->getPhysicsSystem().GetBodyInterface().SetLinearVelocity(bullet.bodyID,
-                            glm_to_jph(glm::angleAxis(enemy.angle, glm::vec3(0, 1, 0)) * glm::vec3(0, 0, -1) * bulletSpeed));
+                    audio.createSingleShot(common.sounds.spiderAttack, enemy.position);
+                    const glm::quat rotation = glm::angleAxis(enemy.angle, glm::vec3(0, 1, 0));
+                    bullets.spawn(jph_to_glm(enemy.character->GetPosition()) + rotation * glm::vec3(0, 0, -0.5),
+                            rotation * glm::vec3(0, 0, -1) * bulletSpeed, enemy.angle, HOSTILE_BULLET);
                 }
                 else if (enemy.state == Enemy::State::Dead)
                 {
+                    bodyEntities.remove(enemy.character->GetBodyID());
                     enemy.character->RemoveFromPhysicsSystem();
                     deathParticles.emplace_back(enemy.position, animationCounter);
                 }
@@ -905,10 +1065,29 @@ struct GameSceneRunner : public JPH::CharacterContactListener
             }
         }
 
-        if (std::erase_if(enemies, [](const auto& enemy){ return enemy.lastState == Enemy::State::Dead; }))
+        // the last enemy takes each dead one's place, so only its body entry needs the new index
+        bool enemyDied = false;
+        for (uint32_t i = 0; i < enemies.size();)
+        {
+            if (enemies[i].lastState != Enemy::State::Dead)
+            {
+                ++i;
+                continue;
+            }
+
+            enemyDied = true;
+            if (i + 1 < enemies.size())
+            {
+                enemies[i] = std::move(enemies.back());
+                bodyEntities.set(enemies[i].character->GetBodyID(), BodyEntity { BodyEntity::Type::Enemy, i });
+            }
+            enemies.pop_back();
+        }
+
+        if (enemyDied)
         {
             counterOverlayTimeStamp = animationTimer;
-            audio.createSingleShot("resources/audio/spiderdeath.wav");
+            audio.createSingleShot(common.sounds.spiderDeath);
             if (enemies.empty())
             {
                 playerState = PlayerStates::FallingInHole;
@@ -916,13 +1095,33 @@ struct GameSceneRunner : public JPH::CharacterContactListener
         }
         std::erase_if(deathParticles, [&](const auto& e) { return animationCounter - e.second >= common.textures.dead.size(); });
 
+        // characters are moved in stepCharacters after each fixed physics step
         physicsWorld->update(deltaTime);
 
+        playerRenderPosition = glm::mix(previousPlayerPosition, jph_to_glm(playerCharacter->GetPosition()), physicsWorld->getInterpolationAlpha());
+        cameraPosition = playerRenderPosition + glm::vec3(0, 5, 0);
+        // heard from the player, oriented like the top down camera so screen right is the right ear
+        audio.setListener(playerRenderPosition, glm::vec3(0, -1, 0), glm::vec3(0, 0, -1));
+
+        if (lastPlayerState != playerState)
+        {
+            playerStateTimer = 0;
+            playerStateAnimationOffset = animationCounter;
+        }
+    }
+
+    void stepCharacters(const float stepTime)
+    {
         for (auto& enemy : enemies)
         {
-            enemy.character->PostSimulation(0.05);
+            if (!enemy.asleep)
+            {
+                enemy.character->PostSimulation(0.05);
+            }
         }
 
+        previousPlayerPosition = jph_to_glm(playerCharacter->GetPosition());
+
         playerCharacter->UpdateGroundVelocity();
         auto velocity = jph_to_glm(playerCharacter->GetLinearVelocity());
 
@@ -934,17 +1133,9 @@ struct GameSceneRunner : public JPH::CharacterContactListener
                 velocity -= glm::dot(normal, velocity) * normal;
             }
         }
-        
-        playerCharacter->SetLinearVelocity(glm_to_jph(velocity));
-        physicsWorld->updateCharacter(*playerCharacter, deltaTime);
 
-        cameraPosition = jph_to_glm(playerCharacter->GetPosition()) + glm::vec3(0, 5, 0);
-
-        if (lastPlayerState != playerState)
-        {
-            playerStateTimer = 0;
-            playerStateAnimationOffset = animationCounter;
-        }
+        playerCharacter->SetLinearVelocity(glm_to_jph(velocity));
+        physicsWorld->updateCharacter(*playerCharacter, stepTime);
     }
 
     void render(eng::SceneInterface& scene)
@@ -979,6 +1170,7 @@ struct GameSceneRunner : public JPH::CharacterContactListener
         for (uint32_t i = 0; i < enemies.size(); ++i)
         {
             const auto& enemy = enemies[i];
+            const glm::vec3 enemyPosition = physicsWorld->getInterpolatedPosition(enemy.character->GetBodyID());
 
             const auto& frames = common.textures.spider[enemy.animationState];
             if (!frames.empty())
@@ -986,15 +1178,17 @@ struct GameSceneRunner : public JPH::CharacterContactListener
                 uint32_t frame = animationCounter - enemy.animationOffset;
                 frame = enemy.loopAnimation ? frame % frames.size() : std::min<uint32_t>(frame, frames.size() - 1);
                 sceneLayer.spriteInstances.push_back(eng::SpriteInstance {
-                            .position = enemy.position,
+                            .position = enemyPosition,
                             .scale = glm::vec3(0.5),
+                            .minTexCoord = frames[frame].minTexCoord,
+                            .texCoordScale = frames[frame].texCoordScale,
                             .angle = enemy.angle,
-                            .textureIndex = frames[frame],
+                            .textureIndex = frames[frame].textureIndex,
                         });
             }
 
             sceneLayer.spriteInstances.push_back(eng::SpriteInstance {
-                        .position = enemy.position + glm::vec3(0, 0, 0.3f),
+                        .position = enemyPosition + glm::vec3(0, 0, 0.3f),
                         .scale = 0.25f * glm::vec3(static_cast<float>(enemy.health) / enemy.maxHealth, 0.1f, 0),
                         .textureIndex = common.textures.blank,
                         .tintColor = glm::vec4(1, 0, 0, 1),
@@ -1003,50 +1197,67 @@ struct GameSceneRunner : public JPH::CharacterContactListener
 
         if (lastPlayerState == PlayerStates::FallingInHole || lastPlayerState == PlayerStates::FallenInHole)
         {
+            const auto& frame = common.textures.hole[std::min<uint32_t>(animationCounter - holeAnimationOffset, common.textures.hole.size()-1)];
             sceneLayer.spriteInstances.push_back(eng::SpriteInstance {
-                        .position = jph_to_glm(playerCharacter->GetPosition()),
+                        .position = playerRenderPosition,
                         .scale = glm::vec3(0.5),
-                        .textureIndex = common.textures.hole[std::min<uint32_t>(animationCounter - holeAnimationOffset, common.textures.hole.size()-1)],
+                        .minTexCoord = frame.minTexCoord,
+                        .texCoordScale = frame.texCoordScale,
+                        .textureIndex = frame.textureIndex,
                     });
         }
         if (!common.textures.player[playerState].empty())
+        {
+            const auto& frame = common.textures.player[playerState][animationCounter % common.textures.player[playerState].size()];
             sceneLayer.spriteInstances.push_back(eng::SpriteInstance {
-                        .position = jph_to_glm(playerCharacter->GetPosition()),
+                        .position = playerRenderPosition,
                         .scale = glm::vec3(0.5),
+                        .minTexCoord = frame.minTexCoord,
+                        .texCoordScale = frame.texCoordScale,
                         .angle = playerAngle,
-                        .textureIndex = common.textures.player[playerState][animationCounter % common.textures.player[playerState].size()],
+                        .textureIndex = frame.textureIndex,
                     });
+        }
         if (playerState == PlayerStates::Shooting)
         {
+            const auto& frame = common.textures.muzzleFlash[std::min<uint32_t>(animationCounter - playerStateAnimationOffset, common.textures.muzzleFlash.size() - 1)];
             sceneLayer.spriteInstances.push_back(eng::SpriteInstance {
-                        .position = jph_to_glm(playerCharacter->GetPosition()) + glm::angleAxis(playerAngle, glm::vec3(0, 1, 0)) * bulletOrigin,
+                        .position = playerRenderPosition + glm::angleAxis(playerAngle, glm::vec3(0, 1, 0)) * bulletOrigin,
                         .scale = glm::vec3(0.5),
+                        .minTexCoord = frame.minTexCoord,
+                        .texCoordScale = frame.texCoordScale,
                         .angle = playerAngle,
-                        .textureIndex = common.textures.muzzleFlash[std::min<uint32_t>(animationCounter - playerStateAnimationOffset, common.textures.muzzleFlash.size() - 1)],
+                        .textureIndex = frame.textureIndex,
                     });
             sceneLayer.lights.push_back(eng::Light {
-                        .position = jph_to_glm(playerCharacter->GetPosition()) + glm::angleAxis(playerAngle, glm::vec3(0, 1, 0)) * bulletOrigin,
+                        .position = playerRenderPosition + glm::angleAxis(playerAngle, glm::vec3(0, 1, 0)) * bulletOrigin,
                         .intensity = glm::vec3(0, 0.5, 0.2),
                     });
         }
         if (playerState == PlayerStates::Dazed)
         {
+            const auto& frame = common.textures.dazed[animationCounter % common.textures.dazed.size()];
             sceneLayer.spriteInstances.push_back(eng::SpriteInstance {
-                        .position = jph_to_glm(playerCharacter->GetPosition()),
+                        .position = playerRenderPosition,
                         .scale = glm::vec3(0.5),
+                        .minTexCoord = frame.minTexCoord,
+                        .texCoordScale = frame.texCoordScale,
                         .angle = playerAngle,
-                        .textureIndex = common.textures.dazed[animationCounter % common.textures.dazed.size()],
+                        .textureIndex = frame.textureIndex,
                     });
         }
 
-        for (const auto& bullet : bullets)
+        for (uint32_t i = 0; i < bullets.size(); ++i)
         {
+            const auto& frame = (bullets.getFlags(i) & FRIENDLY_BULLET) ? common.textures.bullet[animationCounter % common.textures.bullet.size()]
+                : common.textures.spiderBullet[animationCounter % common.textures.spiderBullet.size()];
             sceneLayer.spriteInstances.push_back(eng::SpriteInstance {
-                        .position = jph_to_glm(physicsWorld->getPhysicsSystem().GetBodyInterface().GetPosition(bullet.bodyID)),
+                        .position = bullets.getInterpolatedPosition(i, physicsWorld->getInterpolationAlpha()),
                         .scale = glm::vec3(0.5f),
-                        .angle = bullet.angle,
-                        .textureIndex = bullet.friendly ? common.textures.bullet[animationCounter % common.textures.bullet.size()]
-                            : common.textures.spiderBullet[animationCounter % common.textures.spiderBullet.size()],
+                        .minTexCoord = frame.minTexCoord,
+                        .texCoordScale = frame.texCoordScale,
+                        .angle = bullets.getAngle(i),
+                        .textureIndex = frame.textureIndex,
                     });
         }
 
@@ -1058,13 +1269,15 @@ struct GameSceneRunner : public JPH::CharacterContactListener
                 sceneLayer.spriteInstances.push_back(eng::SpriteInstance {
                             .position = position,
                             .scale = glm::vec3(0.5f),
-                            .textureIndex = common.textures.dead[frame],
+                            .minTexCoord = common.textures.dead[frame].minTexCoord,
+                            .texCoordScale = common.textures.dead[frame].texCoordScale,
+                            .textureIndex = common.textures.dead[frame].textureIndex,
                         });
             }
         }
 
         sceneLayer.lights.push_back(eng::Light {
-                    .position = jph_to_glm(playerCharacter->GetPosition()) + glm::angleAxis(playerAngle, glm::vec3(0, 1, 0)) * glm::vec3(0.25, 1, 0),
+                    .position = playerRenderPosition + glm::angleAxis(playerAngle, glm::vec3(0, 1, 0)) * glm::vec3(0.25, 1, 0),
                     .intensity = glm::vec3(lightIntensity),
                 });
 
@@ -1092,7 +1305,9 @@ struct GameSceneRunner : public JPH::CharacterContactListener
             overlayLayer.spriteInstances.push_back(eng::SpriteInstance {
                     .position = glm::vec3(healthPos.x + 0.5 * healthScale + i * healthSpacing, -healthPos.y - 0.5 * healthScale, 0),
                     .scale = glm::vec3(0.5f * healthScale),
-                    .textureIndex = common.textures.hitpoint,
+                    .minTexCoord = common.textures.hitpoint.minTexCoord,
+                    .texCoordScale = common.textures.hitpoint.texCoordScale,
+                    .textureIndex = common.textures.hitpoint.textureIndex,
                     .tintColor = glm::vec4(1, 0, 0, 1),
                 });
         }
@@ -1123,6 +1338,7 @@ struct GameLogic final: eng::GameLogicInterface
     std::vector<uint32_t> anyActionInputs;
     bool lastPressed = false;
     uint32_t themeLoop;
+    const float themeCrossfadeSeconds = 1.5f;
 
     struct
     {
@@ -1155,7 +1371,7 @@ struct GameLogic final: eng::GameLogicInterface
     {
         themeLoop = audio.createLoop("resources/audio/GasStationThemereal.wav");
 
-        common.reset(new GameCommon(resourceLoader, input));
+        common.reset(new GameCommon(resourceLoader, input, audio));
         anyActionInputs = {
             // input.mapAnyKey(input.createMapping()),
             input.mapAnyMouseButton(input.createMapping()),
@@ -1198,16 +1414,16 @@ struct GameLogic final: eng::GameLogicInterface
             }
             else if (sceneRunner->state == GameSceneRunner::State::Completed)
             {
-                audio.destroyLoop(themeLoop);
+                audio.destroyLoop(themeLoop, themeCrossfadeSeconds);
                 if (currentDungeon < numDungeons)
                 {
-                    if (currentDungeon == 1) themeLoop = audio.createLoop("resources/audio/loop1real.wav");
-                    if (currentDungeon == 2) themeLoop = audio.createLoop("resources/audio/BossBattleMETALloopreal.wav");
+                    if (currentDungeon == 1) themeLoop = audio.createLoop("resources/audio/loop1real.wav", themeCrossfadeSeconds);
+                    if (currentDungeon == 2) themeLoop = audio.createLoop("resources/audio/BossBattleMETALloopreal.wav", themeCrossfadeSeconds);
                     sceneRunner.reset(new GameSceneRunner(*common, currentDungeon++));
                 }
                 else
                 {
-                    themeLoop = audio.createLoop("resources/audio/GasStationThemereal.wav");
+                    themeLoop = audio.createLoop("resources/audio/GasStationThemereal.wav", themeCrossfadeSeconds);
                     currentDungeon = 0;
                     sceneRunner.reset();
                     currentScreen = Screens::Win;
@@ -1217,8 +1433,8 @@ struct GameLogic final: eng::GameLogicInterface
             }
             else if (sceneRunner->state == GameSceneRunner::State::GameOver)
             {
-                audio.destroyLoop(themeLoop);
-                themeLoop = audio.createLoop("resources/audio/GasStationThemereal.wav");
+                audio.destroyLoop(themeLoop, themeCrossfadeSeconds);
+                themeLoop = audio.createLoop("resources/audio/GasStationThemereal.wav", themeCrossfadeSeconds);
                 currentDungeon = 0;
                 sceneRunner.reset();
                 currentScreen = Screens::Lose;
@@ -1229,8 +1445,8 @@ struct GameLogic final: eng::GameLogicInterface
             if (input.getBoolean(inputs.quit))
             {
                 app.requestReload();
-                audio.destroyLoop(themeLoop);
-                themeLoop = audio.createLoop("resources/audio/GasStationThemereal.wav");
+                audio.destroyLoop(themeLoop, themeCrossfadeSeconds);
+                themeLoop = audio.createLoop("resources/audio/GasStationThemereal.wav", themeCrossfadeSeconds);
                 currentDungeon = 0;
                 sceneRunner.reset();
                 currentScreen = Screens::Title;
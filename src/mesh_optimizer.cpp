@@ -0,0 +1,427 @@
+#include "mesh_optimizer.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+using eng::GeometryDescription;
+using eng::MeshOptimizationStats;
+
+namespace
+{
+    // tuning constants from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+    constexpr uint32_t SIMULATED_CACHE_SIZE = 32;
+    constexpr float CACHE_DECAY_POWER = 1.5f;
+    constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+    constexpr float VALENCE_BOOST_SCALE = 2.0f;
+    constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+    constexpr uint32_t ACMR_CACHE_SIZE = 16;
+
+    using VertexKey = std::array<uint32_t, 8>;
+
+    struct VertexKeyHash
+    {
+        size_t operator()(const VertexKey& key) const
+        {
+            uint64_t hash = 14695981039346656037ull;
+            for (const uint32_t value : key)
+            {
+                hash = (hash ^ value) * 1099511628211ull;
+            }
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    VertexKey makeVertexKey(const glm::vec3& position, const glm::vec2& texCoord, const glm::vec3& normal)
+    {
+        // adding zero folds -0.0 into 0.0 so that both weld together
+        const float values[] = {
+            position.x + 0.0f, position.y + 0.0f, position.z + 0.0f,
+            texCoord.x + 0.0f, texCoord.y + 0.0f,
+            normal.x + 0.0f, normal.y + 0.0f, normal.z + 0.0f,
+        };
+
+        VertexKey key;
+        for (uint32_t i = 0; i < key.size(); ++i)
+        {
+            key[i] = std::bit_cast<uint32_t>(values[i]);
+        }
+        return key;
+    }
+
+    float vertexScore(const int32_t cachePosition, const uint32_t remainingTriangles)
+    {
+        if (remainingTriangles == 0)
+        {
+            return -1.0f;
+        }
+
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)
+            {
+                score = LAST_TRIANGLE_SCORE;
+            }
+            else
+            {
+                const float scaler = 1.0f / (SIMULATED_CACHE_SIZE - 3);
+                score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+            }
+        }
+
+        return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+    }
+
+    std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices, const uint32_t vertexCount)
+    {
+        const uint32_t triangleCount = indices.size() / 3;
+
+        // per-vertex lists of triangles not yet emitted
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+        for (const uint32_t index : indices)
+        {
+            ++adjacencyOffsets[index + 1];
+        }
+        for (uint32_t i = 0; i < vertexCount; ++i)
+        {
+            adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+        }
+
+        std::vector<uint32_t> adjacency(indices.size());
+        std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+        for (uint32_t triangle = 0; triangle < triangleCount; ++triangle)
+        {
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                const uint32_t vertex = indices[3 * triangle + k];
+                adjacency[adjacencyOffsets[vertex] + remainingTriangles[vertex]++] = triangle;
+            }
+        }
+
+        std::vector<int32_t> cachePositions(vertexCount, -1);
+        std::vector<float> vertexScores(vertexCount);
+        for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            vertexScores[vertex] = vertexScore(-1, remainingTriangles[vertex]);
+        }
+
+        std::vector<float> triangleScores(triangleCount);
+        for (uint32_t triangle = 0; triangle < triangleCount; ++triangle)
+        {
+            triangleScores[triangle] = vertexScores[indices[3 * triangle]]
+                + vertexScores[indices[3 * triangle + 1]]
+                + vertexScores[indices[3 * triangle + 2]];
+        }
+
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> cache;
+        std::vector<uint32_t> newCache;
+        cache.reserve(SIMULATED_CACHE_SIZE + 3);
+        newCache.reserve(SIMULATED_CACHE_SIZE + 3);
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+
+        uint32_t nextUnemitted = 0;
+        uint32_t bestTriangle = UINT32_MAX;
+
+        for (uint32_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+        {
+            if (bestTriangle == UINT32_MAX)
+            {
+                // nothing connected to the cache, restart from the next unused triangle
+                while (emitted[nextUnemitted])
+                {
+                    ++nextUnemitted;
+                }
+                bestTriangle = nextUnemitted;
+            }
+
+            const uint32_t triangle = bestTriangle;
+            emitted[triangle] = true;
+
+            newCache.clear();
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                const uint32_t vertex = indices[3 * triangle + k];
+                result.push_back(vertex);
+                newCache.push_back(vertex);
+
+                const auto begin = adjacency.begin() + adjacencyOffsets[vertex];
+                const auto end = begin + remainingTriangles[vertex];
+                std::iter_swap(std::find(begin, end, triangle), end - 1);
+                --remainingTriangles[vertex];
+            }
+
+            for (const uint32_t vertex : cache)
+            {
+                if (std::find(newCache.begin(), newCache.end(), vertex) == newCache.end())
+                {
+                    newCache.push_back(vertex);
+                }
+            }
+
+            // update scores of everything that moved in or fell out of the cache
+            for (uint32_t i = 0; i < newCache.size(); ++i)
+            {
+                const uint32_t vertex = newCache[i];
+                cachePositions[vertex] = i < SIMULATED_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+
+                const float score = vertexScore(cachePositions[vertex], remainingTriangles[vertex]);
+                const float delta = score - vertexScores[vertex];
+                vertexScores[vertex] = score;
+
+                for (uint32_t j = 0; j < remainingTriangles[vertex]; ++j)
+                {
+                    triangleScores[adjacency[adjacencyOffsets[vertex] + j]] += delta;
+                }
+            }
+
+            if (newCache.size() > SIMULATED_CACHE_SIZE)
+            {
+                newCache.resize(SIMULATED_CACHE_SIZE);
+            }
+            std::swap(cache, newCache);
+
+            bestTriangle = UINT32_MAX;
+            float bestScore = -1.0f;
+            for (const uint32_t vertex : cache)
+            {
+                for (uint32_t j = 0; j < remainingTriangles[vertex]; ++j)
+                {
+                    const uint32_t candidate = adjacency[adjacencyOffsets[vertex] + j];
+                    if (triangleScores[candidate] > bestScore)
+                    {
+                        bestScore = triangleScores[candidate];
+                        bestTriangle = candidate;
+                    }
+                }
+            }
+        }
+
+        return result;
+    }
+
+    // Coarse front-to-back ordering after Sander et al., "Fast Triangle Reordering for Vertex Locality and
+    // Reduced Overdraw". The cache-ordered list is cut into clusters wherever the cache restarts, and clusters
+    // that face away from the mesh center are drawn first since they are likely to occlude the rest.
+    std::vector<uint32_t> optimizeOverdraw(const std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions)
+    {
+        const uint32_t triangleCount = indices.size() / 3;
+
+        std::vector<uint32_t> clusterStarts;
+        {
+            std::vector<uint32_t> timestamps(positions.size(), 0);
+            uint32_t time = ACMR_CACHE_SIZE + 1;
+            for (uint32_t triangle = 0; triangle < triangleCount; ++triangle)
+            {
+                uint32_t misses = 0;
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    const uint32_t vertex = indices[3 * triangle + k];
+                    if (time - timestamps[vertex] > ACMR_CACHE_SIZE)
+                    {
+                        timestamps[vertex] = time++;
+                        ++misses;
+                    }
+                }
+
+                if (misses == 3 || triangle == 0)
+                {
+                    clusterStarts.push_back(triangle);
+                }
+            }
+        }
+        clusterStarts.push_back(triangleCount);
+
+        glm::vec3 meshCentroid(0);
+        float meshArea = 0.0f;
+
+        struct Cluster
+        {
+            uint32_t firstTriangle;
+            uint32_t triangleCount;
+            glm::vec3 centroid;
+            glm::vec3 normal;
+            float sortKey;
+        };
+        std::vector<Cluster> clusters;
+        clusters.reserve(clusterStarts.size() - 1);
+
+        for (uint32_t c = 0; c + 1 < clusterStarts.size(); ++c)
+        {
+            Cluster cluster {
+                .firstTriangle = clusterStarts[c],
+                .triangleCount = clusterStarts[c + 1] - clusterStarts[c],
+                .centroid = glm::vec3(0),
+                .normal = glm::vec3(0),
+                .sortKey = 0.0f,
+            };
+
+            float clusterArea = 0.0f;
+            for (uint32_t triangle = cluster.firstTriangle; triangle < clusterStarts[c + 1]; ++triangle)
+            {
+                const glm::vec3& p0 = positions[indices[3 * triangle]];
+                const glm::vec3& p1 = positions[indices[3 * triangle + 1]];
+                const glm::vec3& p2 = positions[indices[3 * triangle + 2]];
+
+                const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+                const float area = 0.5f * glm::length(normal);
+
+                cluster.centroid += area * (p0 + p1 + p2) / 3.0f;
+                cluster.normal += normal;
+                clusterArea += area;
+            }
+
+            meshCentroid += cluster.centroid;
+            meshArea += clusterArea;
+
+            if (clusterArea > 0.0f)
+            {
+                cluster.centroid /= clusterArea;
+            }
+            clusters.push_back(cluster);
+        }
+
+        if (meshArea > 0.0f)
+        {
+            meshCentroid /= meshArea;
+        }
+
+        for (auto& cluster : clusters)
+        {
+            const float normalLength = glm::length(cluster.normal);
+            cluster.sortKey = normalLength > 0.0f
+                ? glm::dot(cluster.centroid - meshCentroid, cluster.normal / normalLength)
+                : 0.0f;
+        }
+
+        std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b)
+        {
+            return a.sortKey > b.sortKey;
+        });
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        for (const auto& cluster : clusters)
+        {
+            const auto begin = indices.begin() + 3 * cluster.firstTriangle;
+            result.insert(result.end(), begin, begin + 3 * cluster.triangleCount);
+        }
+
+        return result;
+    }
+}
+
+float eng::computeACMR(const std::vector<uint32_t>& indices, const uint32_t vertexCount, const uint32_t cacheSize)
+{
+    if (indices.size() < 3)
+    {
+        return 0.0f;
+    }
+
+    // FIFO cache: a vertex is resident while fewer than cacheSize misses have happened since it was loaded
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    uint32_t misses = 0;
+    for (const uint32_t index : indices)
+    {
+        if (time - timestamps[index] > cacheSize)
+        {
+            timestamps[index] = time++;
+            ++misses;
+        }
+    }
+
+    return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+}
+
+GeometryDescription eng::optimizeGeometry(const GeometryDescription& description, MeshOptimizationStats* stats)
+{
+    const uint32_t vertexCount = description.positions.size();
+    if (description.texCoords.size() != vertexCount || description.normals.size() != vertexCount)
+    {
+        throw std::runtime_error("count of vertex positions, tex coords and normals must match");
+    }
+    if (description.indices.size() % 3 != 0)
+    {
+        throw std::runtime_error("index count must be a multiple of 3");
+    }
+    for (const uint32_t index : description.indices)
+    {
+        if (index >= vertexCount)
+        {
+            throw std::runtime_error("index out of range of vertex data");
+        }
+    }
+
+    // weld vertices with bitwise identical attributes
+    GeometryDescription welded;
+    std::vector<uint32_t> remap(vertexCount);
+    {
+        std::unordered_map<VertexKey, uint32_t, VertexKeyHash> uniqueVertices;
+        uniqueVertices.reserve(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; ++i)
+        {
+            const auto [it, inserted] = uniqueVertices.try_emplace(
+                    makeVertexKey(description.positions[i], description.texCoords[i], description.normals[i]),
+                    static_cast<uint32_t>(welded.positions.size()));
+            if (inserted)
+            {
+                welded.positions.push_back(description.positions[i]);
+                welded.texCoords.push_back(description.texCoords[i]);
+                welded.normals.push_back(description.normals[i]);
+            }
+            remap[i] = it->second;
+        }
+    }
+
+    welded.indices.reserve(description.indices.size());
+    for (uint32_t i = 0; i < description.indices.size(); i += 3)
+    {
+        const uint32_t a = remap[description.indices[i]];
+        const uint32_t b = remap[description.indices[i + 1]];
+        const uint32_t c = remap[description.indices[i + 2]];
+        if (a != b && b != c && c != a)
+        {
+            welded.indices.insert(welded.indices.end(), { a, b, c });
+        }
+    }
+
+    const uint32_t weldedVertexCount = welded.positions.size();
+    const std::vector<uint32_t> orderedIndices = optimizeOverdraw(optimizeVertexCache(welded.indices, weldedVertexCount), welded.positions);
+
+    // lay out vertices in the order they are first referenced
+    GeometryDescription result;
+    result.indices.reserve(orderedIndices.size());
+    std::vector<uint32_t> fetchRemap(weldedVertexCount, UINT32_MAX);
+    for (const uint32_t index : orderedIndices)
+    {
+        if (fetchRemap[index] == UINT32_MAX)
+        {
+            fetchRemap[index] = result.positions.size();
+            result.positions.push_back(welded.positions[index]);
+            result.texCoords.push_back(welded.texCoords[index]);
+            result.normals.push_back(welded.normals[index]);
+        }
+        result.indices.push_back(fetchRemap[index]);
+    }
+
+    if (stats)
+    {
+        *stats = {
+            .vertexCountBefore = vertexCount,
+            .vertexCountAfter = static_cast<uint32_t>(result.positions.size()),
+            .triangleCountBefore = static_cast<uint32_t>(description.indices.size() / 3),
+            .triangleCountAfter = static_cast<uint32_t>(result.indices.size() / 3),
+            .acmrBefore = computeACMR(description.indices, vertexCount, ACMR_CACHE_SIZE),
+            .acmrAfter = computeACMR(result.indices, result.positions.size(), ACMR_CACHE_SIZE),
+        };
+    }
+
+    return result;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "engine.hpp"
+
+namespace eng
+{
+    struct MeshOptimizationStats
+    {
+        uint32_t vertexCountBefore = 0;
+        uint32_t vertexCountAfter = 0;
+        uint32_t triangleCountBefore = 0;
+        uint32_t triangleCountAfter = 0;
+        float acmrBefore = 0.0f;
+        float acmrAfter = 0.0f;
+    };
+
+    // average cache miss ratio (transformed vertices per triangle) for a FIFO post-transform cache
+    float computeACMR(const std::vector<uint32_t>& indices, const uint32_t vertexCount, const uint32_t cacheSize = 16);
+
+    // welds identical vertices, drops degenerate triangles, reorders triangles for the post-transform
+    // vertex cache and then coarsely front-to-back for overdraw, and finally reorders vertices by first use
+    GeometryDescription optimizeGeometry(const GeometryDescription& description, MeshOptimizationStats* stats = nullptr);
+}
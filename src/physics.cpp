@@ -1,16 +1,20 @@
 #include "physics.hpp"
+#include "contact_listener.hpp"
+#include "jph_glm_convert.hpp"
+#include "robin_hood_table.hpp"
 #include "util.hpp"
 
 #include <Jolt/Jolt.h>
 #include <Jolt/Core/Factory.h>
-#include <Jolt/Core/JobSystemSingleThreaded.h>
+#include <Jolt/Core/JobSystemThreadPool.h>
 #include <Jolt/Core/TempAllocator.h>
-#include <Jolt/Core/UnorderedMap.h>
 #include <Jolt/Physics/Body/BodyActivationListener.h>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
 #include <Jolt/Physics/Character/CharacterVirtual.h>
 #include <Jolt/Physics/Collision/BroadPhase/BroadPhaseLayerInterfaceTable.h>
 #include <Jolt/Physics/Collision/BroadPhase/ObjectVsBroadPhaseLayerFilterTable.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Collision/RayCast.h>
 #include <Jolt/Physics/Collision/ObjectLayerPairFilterTable.h>
 #include <Jolt/Physics/Collision/Shape/BoxShape.h>
 #include <Jolt/Physics/Collision/Shape/CapsuleShape.h>
@@ -20,21 +24,39 @@
 #include <Jolt/Physics/Collision/Shape/SphereShape.h>
 #include <Jolt/Physics/PhysicsSettings.h>
 #include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/StateRecorderImpl.h>
 #include <Jolt/RegisterTypes.h>
-
-// from: Matthias Mueller: https://matthias-research.github.io/pages/publications/realtimeCoursenotes.pdf
-static uint32_t spatialHash(int x, int y, int z)
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// once per process, the job system needs Jolt's allocator before any world exists
+static void initializeJolt()
 {
-    return (uint32_t)((x * 92837111ul) ^ (y * 689287499ul) ^ (z * 283923481ul));
+    static const bool initialized = []
+    {
+        JPH::RegisterDefaultAllocator();
+        JPH::Factory::sInstance = new JPH::Factory;
+        JPH::RegisterTypes();
+        return true;
+    }();
+    (void)initialized;
 }
 
 struct JoltInitialization
 {
     JoltInitialization()
     {
-        JPH::RegisterDefaultAllocator();
-        JPH::Factory::sInstance = new JPH::Factory;
-        JPH::RegisterTypes();
+        initializeJolt();
     }
 };
 
@@ -62,189 +84,204 @@ struct ObjectLayerFilter
     }
 };
 
-struct CollisionPairRecord
+struct CachedRay
 {
-    JPH::BodyID bodies[2];
-    uint32_t hash;
-    uint32_t hashTableIndex;
-    std::vector<std::pair<JPH::SubShapeIDPair, JPH::ContactManifold>> contacts;
+    fff::RayQuery ray;
+    fff::RayHit hit;
 };
 
-struct ContactListener final: public JPH::ContactListener
+static uint64_t getRayKey(const fff::RayQuery& ray)
 {
-    JPH::BodyInterface& bodyInterface;
-    std::mutex mutex;
-    std::vector<uint32_t> collisionPairsMap;
-    std::vector<CollisionPairRecord> collisionPairs;
-    std::vector<std::pair<JPH::BodyID, JPH::BodyID>> addedPairs;
-    std::vector<std::pair<JPH::BodyID, JPH::BodyID>> removedPairs;
-    JPH::UnorderedMap<JPH::SubShapeIDPair, uint32_t> subShapePairsMap;
-
-    explicit ContactListener(JPH::BodyInterface& bodyInterface)
-        : bodyInterface(bodyInterface), collisionPairsMap(1024, UINT32_MAX)
+    // FNV-1a over the ray's values, the table mixes the bits further
+    const float values[] = { ray.origin.x, ray.origin.y, ray.origin.z, ray.direction.x, ray.direction.y, ray.direction.z };
+    uint64_t key = 0xcbf29ce484222325ull ^ ray.broadPhaseLayers;
+    for (const float value : values)
     {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        key = (key ^ bits) * 0x100000001b3ull;
     }
+    return key;
+}
 
-    ~ContactListener()
+static bool isSameRay(const fff::RayQuery& a, const fff::RayQuery& b)
+{
+    return a.origin == b.origin && a.direction == b.direction && a.broadPhaseLayers == b.broadPhaseLayers;
+}
+
+struct BroadPhaseLayerMaskFilter final : public JPH::BroadPhaseLayerFilter
+{
+    const uint32_t mask;
+
+    explicit BroadPhaseLayerMaskFilter(const uint32_t mask) :
+        mask(mask)
     {
     }
 
-    void ExpandHashTable()
+    bool ShouldCollide(JPH::BroadPhaseLayer layer) const override
     {
-        collisionPairsMap.assign(collisionPairsMap.size() * 2, UINT32_MAX);
+        return mask & (1u << layer.GetValue());
+    }
+};
 
-        for (uint32_t i = 0; i < collisionPairs.size(); ++i)
-        {
-            auto& pair = collisionPairs[i];
+// Per-step rows for the LD57_PHYSICS_STATS file, shared by every world in the process so later levels and
+// restarts don't wipe the earlier ones. Rows are appended to an open stream and flushed every so often. Once the
+// file holds FILE_ROWS rows it's moved to <path>.1, replacing the previous one, and a fresh file is started, so
+// the latest steps are kept without the files growing without bound.
+class StatsCsvSink
+{
+    static constexpr uint32_t FILE_ROWS = 36000;
+    static constexpr uint32_t FLUSH_INTERVAL = 60;
 
-            for (uint32_t j = 0; j < collisionPairsMap.size(); ++j)
-            {
-                uint32_t index = (pair.hash + j) % collisionPairsMap.size();
-                if (collisionPairsMap[index] == UINT32_MAX)
-                {
-                    collisionPairsMap[index] = i;
-                    pair.hashTableIndex = index;
-                    break;
-                }
-            }
-        }
+    std::mutex mutex;
+    std::string path;
+    std::ofstream file;
+    uint32_t rows = 0;
+    uint32_t nextWorld = 0;
+
+    explicit StatsCsvSink(const char* path) :
+        path(path)
+    {
+        open();
     }
 
-    CollisionPairRecord* SearchPair(uint32_t pairHash, const JPH::BodyID body0, const JPH::BodyID body1, uint32_t* hashTableIndex = nullptr)
+    void open()
     {
-        for (uint32_t i = 0; i < collisionPairsMap.size(); ++i)
+        file.open(path, std::ios::trunc);
+        if (!file)
         {
-            uint32_t hashIndex = (pairHash + i) % collisionPairsMap.size();
-            uint32_t pairIndex = collisionPairsMap[hashIndex];
-            if (pairIndex == UINT32_MAX)
-            {
-                if (hashTableIndex) *hashTableIndex = hashIndex;
-                return nullptr;
-            }
-
-            auto& pair = collisionPairs[pairIndex];
-            if (pair.hash == pairHash && pair.bodies[0] == body0 && pair.bodies[1] == body1)
-            {
-                if (hashTableIndex) *hashTableIndex = hashIndex;
-                return &pair;
-            }
+            std::cerr << "Failed to open physics stats file " << path << std::endl;
+            return;
         }
+        file << "world,step,update_ms,callback_ms,character_ms,active_bodies,touching_body_pairs,touching_sub_shape_pairs,"
+            "contact_events,contact_constraints,peak_temp_bytes\n";
+        rows = 0;
+    }
 
-        if (hashTableIndex) *hashTableIndex = UINT32_MAX;
+public:
+    // nullptr when LD57_PHYSICS_STATS isn't set
+    static StatsCsvSink* get()
+    {
+        static const std::unique_ptr<StatsCsvSink> sink = []
+        {
+            const char* path = std::getenv("LD57_PHYSICS_STATS");
+            return path ? std::unique_ptr<StatsCsvSink>(new StatsCsvSink(path)) : nullptr;
+        }();
+        return sink.get();
+    }
 
-        return nullptr;
+    // numbers the worlds in creation order, for the world column
+    uint32_t addWorld()
+    {
+        std::lock_guard lock(mutex);
+        return nextWorld++;
     }
 
-    const CollisionPairRecord* FindPair(const JPH::BodyID body0, const JPH::BodyID body1) const
+    void write(const uint32_t world, const fff::PhysicsStepStats& stats)
     {
-        if (body1 < body0)
+        std::lock_guard lock(mutex);
+        if (rows == FILE_ROWS)
         {
-            return FindPair(body1, body0);
+            file.close();
+            const std::string previousPath = path + ".1";
+            std::remove(previousPath.c_str());
+            std::rename(path.c_str(), previousPath.c_str());
+            open();
         }
-
-        uint32_t pairHash = spatialHash((int)body0.GetIndex(), (int)body1.GetIndex(), 0);
-        for (uint32_t i = 0; i < collisionPairsMap.size(); ++i)
+        if (!file.is_open())
         {
-            uint32_t hashIndex = (pairHash + i) % collisionPairsMap.size();
-            uint32_t pairIndex = collisionPairsMap[hashIndex];
-            if (pairIndex == UINT32_MAX)
-            {
-                return nullptr;
-            }
-
-            auto& pair = collisionPairs[pairIndex];
-            if (pair.hash == pairHash && pair.bodies[0] == body0 && pair.bodies[1] == body1)
-            {
-                return &pair;
-            }
+            return;
         }
 
-        return nullptr;
+        file << world << ',' << stats.step << ',' << stats.updateTime << ',' << stats.callbackTime << ',' << stats.characterTime << ','
+            << stats.activeBodies << ',' << stats.touchingBodyPairs << ',' << stats.touchingSubShapePairs << ','
+            << stats.contactEvents << ',' << stats.contactConstraints << ',' << stats.peakTempUsage << '\n';
+        if (++rows % FLUSH_INTERVAL == 0)
+        {
+            file.flush();
+        }
     }
+};
 
-    CollisionPairRecord& GetPair(const JPH::BodyID body0, const JPH::BodyID body1, uint32_t* outHashTableIndex = nullptr)
+// Jolt's fixed block allocator with malloc fallback, so updates don't hit malloc until a step needs more than
+// the block. Wrapped to warn on the first overflow and to measure the peak, which shows how big the block should
+// be. Jolt doesn't say where an allocation went, so the block's stack top is mirrored here with the same test the
+// fallback makes, and overflowed addresses are kept until they're freed to tell them apart.
+class BudgetedTempAllocator final : public JPH::TempAllocator
+{
+    JPH::TempAllocatorImplWithMallocFallback allocator;
+    const uint32_t blockSize;
+    uint32_t blockUsage = 0;
+    uint32_t fallbackUsage = 0;
+    std::vector<void*> fallbackAllocations;
+    uint32_t peakUsage = 0;
+    uint32_t stepPeakUsage = 0;
+    uint32_t overflowCount = 0;
+
+public:
+    explicit BudgetedTempAllocator(const uint32_t size) :
+        allocator(size),
+        blockSize(size)
     {
-        if (body1 < body0)
-        {
-            return GetPair(body1, body0, outHashTableIndex);
-        }
+    }
 
-        uint32_t pairHash = spatialHash((int)body0.GetIndex(), (int)body1.GetIndex(), 0);
-        uint32_t hashTableIndex;
-        CollisionPairRecord* record = SearchPair(pairHash, body0, body1, &hashTableIndex);
-        if (outHashTableIndex) *outHashTableIndex = hashTableIndex;
-        if (record)
+    void* Allocate(JPH::uint size) override
+    {
+        void* address = allocator.Allocate(size);
+        if (const uint32_t alignedSize = JPH::AlignUp(size, JPH_RVECTOR_ALIGNMENT); blockUsage + alignedSize <= blockSize)
         {
-            return *record;
+            blockUsage += alignedSize;
         }
-
-        if (hashTableIndex == UINT32_MAX)
+        else
         {
-            ExpandHashTable();
-            SearchPair(pairHash, body0, body1, &hashTableIndex);
-            if (outHashTableIndex) *outHashTableIndex = hashTableIndex;
+            if (overflowCount++ == 0)
+            {
+                std::cerr << "Physics temp allocator overflowed its " << blockSize << " bytes, falling back to malloc" << std::endl;
+            }
+            fallbackUsage += size;
+            fallbackAllocations.push_back(address);
         }
 
-        if (outHashTableIndex) *outHashTableIndex = hashTableIndex;
-        collisionPairsMap[hashTableIndex] = collisionPairs.size();
-
-        collisionPairs.push_back({{ body0, body1 }, pairHash, hashTableIndex, {}});
-        addedPairs.emplace_back(body0, body1);
-
-        return collisionPairs.back();
+        stepPeakUsage = std::max(stepPeakUsage, blockUsage + fallbackUsage);
+        peakUsage = std::max(peakUsage, stepPeakUsage);
+        return address;
     }
 
-    void OnContactAdded(const JPH::Body& body0, const JPH::Body& body1, const JPH::ContactManifold& manifold, JPH::ContactSettings&) override
+    void Free(void* address, JPH::uint size) override
     {
-        std::lock_guard lock(mutex);
-        uint32_t hashTableIndex;
-        auto& pair = GetPair(body0.GetID(), body1.GetID(), &hashTableIndex);
-        JPH::SubShapeIDPair idPair(body0.GetID(), manifold.mSubShapeID1, body1.GetID(), manifold.mSubShapeID2);
-        subShapePairsMap[idPair] = hashTableIndex;
+        if (!address)
+        {
+            return;
+        }
 
-        for (uint32_t i = 0; i < pair.contacts.size(); ++i)
+        // freed in reverse order, an overflowed allocation is usually the last one
+        if (const auto fallback = std::find(fallbackAllocations.rbegin(), fallbackAllocations.rend(), address); fallback != fallbackAllocations.rend())
         {
-            if (pair.contacts[i].first == idPair)
-            {
-                pair.contacts[i].second = manifold;
-                return;
-            }
+            fallbackAllocations.erase(std::next(fallback).base());
+            fallbackUsage -= size;
         }
-        pair.contacts.push_back({ idPair, manifold });
+        else
+        {
+            blockUsage -= JPH::AlignUp(size, JPH_RVECTOR_ALIGNMENT);
+        }
+        allocator.Free(address, size);
     }
 
-    void OnContactPersisted(const JPH::Body& body0, const JPH::Body& body1, const JPH::ContactManifold& manifold, JPH::ContactSettings& settings) override
+    // peak since the last call
+    uint32_t takeStepPeakUsage()
     {
-        OnContactAdded(body0, body1, manifold, settings);
+        const uint32_t usage = stepPeakUsage;
+        stepPeakUsage = blockUsage + fallbackUsage;
+        return usage;
     }
 
-    void OnContactRemoved(const JPH::SubShapeIDPair& subShapeIDPair) override
+    fff::PhysicsMemoryStats getStats() const
     {
-        std::lock_guard lock(mutex);
-        auto iter = subShapePairsMap.find(subShapeIDPair);
-        if (iter == subShapePairsMap.end()) return;
-        auto hashTableIndex = iter->second;
-        subShapePairsMap.erase(iter);
-
-        uint32_t pairIndex = collisionPairsMap[hashTableIndex];
-        auto& pair = collisionPairs[pairIndex];
-        auto contactIter = std::find_if(pair.contacts.begin(), pair.contacts.end(), [&](const auto& c) {
-                return c.first == subShapeIDPair;
-            });
-        if (contactIter == pair.contacts.end()) return;
-        pair.contacts.erase(contactIter);
-
-        if (pair.contacts.empty())
-        {
-            removedPairs.emplace_back(pair.bodies[0], pair.bodies[1]);
-            collisionPairsMap[hashTableIndex] = UINT32_MAX;
-            if (pairIndex < collisionPairs.size() - 1)
-            {
-                pair = std::move(collisionPairs.back());
-                collisionPairs.pop_back();
-                collisionPairsMap[pair.hashTableIndex] = pairIndex;
-            }
-        }
+        return fff::PhysicsMemoryStats {
+            .tempAllocatorSize = blockSize,
+            .peakTempUsage = peakUsage,
+            .tempOverflowCount = overflowCount,
+        };
     }
 };
 
@@ -252,26 +289,73 @@ struct PhysicsWorld final :
     fff::PhysicsWorldInterface,
     JoltInitialization
 {
-    JPH::TempAllocatorMalloc tempAllocator;
-    JPH::JobSystemSingleThreaded jobSystem;
+    BudgetedTempAllocator tempAllocator;
+    JPH::JobSystem& jobSystem;
+    const int collisionSteps;
+    const float stepTime;
+    const uint32_t maxSubsteps;
+    float accumulator = 0.0f;
     BroadphaseLayer broadPhaseLayer;
     ObjectLayerFilter objectLayerFilter;
     JPH::ObjectVsBroadPhaseLayerFilterTable objectVsBroadPhaseLayerFilter;
     JPH::PhysicsSystem physicsSystem;
     InitShim<&JPH::PhysicsSystem::Init> initPhysicsSystem;
-    ContactListener contactListener;
+    fff::ContactListener contactListener;
     std::function<void(const JPH::BodyID, const JPH::BodyID)> onCollisionEnter = nullptr;
     std::function<void(const JPH::BodyID, const JPH::BodyID)> onCollisionExit = nullptr;
-
-    PhysicsWorld() :
-        tempAllocator(),
-        jobSystem(JPH::cMaxPhysicsJobs),
+    std::function<void(float)> onStep = nullptr;
+
+    // positions before the latest step, by body index. bodies that weren't active then haven't moved since
+    JPH::BodyIDVector activeBodies;
+    std::vector<JPH::RVec3> previousPositions;
+    std::vector<JPH::BodyID> previousBodies;
+    std::vector<uint64_t> previousSteps;
+    uint64_t stepCount = 0;
+
+    static constexpr uint32_t RAYS_PER_JOB = 32;
+    // cleared every step, bodies may have moved
+    fff::RobinHoodTable<CachedRay> rayCache;
+    std::vector<uint32_t> uncachedRays;
+
+    // ring buffer of the latest steps, each step also goes to the stats file when LD57_PHYSICS_STATS is set
+    static constexpr uint32_t STATS_HISTORY = 600;
+    fff::PhysicsStepStats stepStats = {};
+    std::vector<fff::PhysicsStepStats> statsHistory;
+    // where the next step goes once the history is full, which is also the oldest one
+    uint32_t statsNext = 0;
+    StatsCsvSink* const statsSink = StatsCsvSink::get();
+    const uint32_t statsWorld = statsSink ? statsSink->addWorld() : 0;
+    float characterTime = 0.0f;
+
+    PhysicsWorld(JPH::JobSystem& jobSystem, const fff::PhysicsWorldSettings& settings) :
+        tempAllocator(settings.tempAllocatorSize),
+        jobSystem(jobSystem),
+        collisionSteps(std::max(settings.collisionSteps, 1)),
+        stepTime(1.0f / settings.stepRate),
+        maxSubsteps(std::max(settings.maxSubsteps, 1u)),
         objectVsBroadPhaseLayerFilter(broadPhaseLayer.table, 2, objectLayerFilter.filter, 2),
         physicsSystem(),
-        initPhysicsSystem(physicsSystem, 65536, 0, 65536, 10240, broadPhaseLayer.table, objectVsBroadPhaseLayerFilter, objectLayerFilter.filter),
-        contactListener(physicsSystem.GetBodyInterface())
+        initPhysicsSystem(physicsSystem, settings.maxBodies, settings.numBodyMutexes, settings.maxBodyPairs, settings.maxContactConstraints,
+                broadPhaseLayer.table, objectVsBroadPhaseLayerFilter, objectLayerFilter.filter)
     {
         physicsSystem.SetContactListener(&contactListener);
+
+        previousPositions.resize(physicsSystem.GetMaxBodies());
+        previousBodies.resize(physicsSystem.GetMaxBodies());
+        previousSteps.resize(physicsSystem.GetMaxBodies(), 0);
+
+        statsHistory.reserve(STATS_HISTORY);
+    }
+
+    ~PhysicsWorld()
+    {
+        const auto stats = tempAllocator.getStats();
+        std::cout << "Physics temp allocator peak usage: " << stats.peakTempUsage << " of " << stats.tempAllocatorSize << " bytes";
+        if (stats.tempOverflowCount > 0)
+        {
+            std::cout << ", " << stats.tempOverflowCount << " allocations overflowed";
+        }
+        std::cout << std::endl;
     }
 
     JPH::PhysicsSystem& getPhysicsSystem() override
@@ -281,7 +365,47 @@ struct PhysicsWorld final :
 
     void update(const float deltaTime) override
     {
-        physicsSystem.Update(deltaTime, 1, &tempAllocator, &jobSystem);
+        // bodies may have been added or removed since the last query even when no step runs this frame
+        invalidateRayCache();
+        accumulator += deltaTime;
+
+        uint32_t steps = 0;
+        while (accumulator >= stepTime && steps < maxSubsteps)
+        {
+            step();
+            accumulator -= stepTime;
+            ++steps;
+        }
+
+        if (steps == maxSubsteps)
+        {
+            accumulator = std::min(accumulator, stepTime);
+        }
+    }
+
+    static float getMilliseconds(const std::chrono::steady_clock::time_point start, const std::chrono::steady_clock::time_point end)
+    {
+        return std::chrono::duration<float, std::milli>(end - start).count();
+    }
+
+    void step()
+    {
+        const auto startTime = std::chrono::steady_clock::now();
+        ++stepCount;
+        invalidateRayCache();
+        const JPH::BodyInterface& bodyInterface = physicsSystem.GetBodyInterfaceNoLock();
+        physicsSystem.GetActiveBodies(JPH::EBodyType::RigidBody, activeBodies);
+        for (const auto body : activeBodies)
+        {
+            const uint32_t index = body.GetIndex();
+            previousPositions[index] = bodyInterface.GetPosition(body);
+            previousBodies[index] = body;
+            previousSteps[index] = stepCount;
+        }
+
+        physicsSystem.Update(stepTime, collisionSteps, &tempAllocator, &jobSystem);
+        const auto updateEndTime = std::chrono::steady_clock::now();
+        contactListener.MergeEvents();
 
         if (onCollisionEnter) for (auto&& [body0, body1] : contactListener.addedPairs)
         {
@@ -295,15 +419,102 @@ struct PhysicsWorld final :
         }
         contactListener.addedPairs.clear();
         contactListener.removedPairs.clear();
+
+        characterTime = 0.0f;
+        if (onStep)
+        {
+            onStep(stepTime);
+        }
+
+        recordStepStats(startTime, updateEndTime);
+    }
+
+    void recordStepStats(const std::chrono::steady_clock::time_point startTime, const std::chrono::steady_clock::time_point updateEndTime)
+    {
+        stepStats = fff::PhysicsStepStats {
+            .step = stepCount,
+            .updateTime = getMilliseconds(startTime, updateEndTime),
+            .callbackTime = getMilliseconds(updateEndTime, std::chrono::steady_clock::now()),
+            .characterTime = characterTime,
+            .activeBodies = physicsSystem.GetNumActiveBodies(JPH::EBodyType::RigidBody),
+            .touchingBodyPairs = static_cast<uint32_t>(contactListener.collisionPairs.size()),
+            .touchingSubShapePairs = static_cast<uint32_t>(contactListener.subShapePairsMap.size()),
+            .contactEvents = static_cast<uint32_t>(contactListener.mergedEvents.size()),
+            .contactConstraints = contactListener.contactConstraints,
+            .peakTempUsage = tempAllocator.takeStepPeakUsage(),
+        };
+
+        if (statsHistory.size() < STATS_HISTORY)
+        {
+            statsHistory.push_back(stepStats);
+        }
+        else
+        {
+            statsHistory[statsNext] = stepStats;
+            statsNext = (statsNext + 1) % STATS_HISTORY;
+        }
+
+        if (statsSink)
+        {
+            statsSink->write(statsWorld, stepStats);
+        }
+    }
+
+    const fff::PhysicsStepStats& getStepStats() const override
+    {
+        return stepStats;
+    }
+
+    void getStepStatsHistory(std::vector<fff::PhysicsStepStats>& stats) const override
+    {
+        stats.clear();
+        if (statsHistory.size() < STATS_HISTORY)
+        {
+            stats.assign(statsHistory.begin(), statsHistory.end());
+            return;
+        }
+
+        const auto oldest = statsHistory.begin() + statsNext;
+        stats.assign(oldest, statsHistory.end());
+        stats.insert(stats.end(), statsHistory.begin(), oldest);
+    }
+
+    void setOnStep(const std::function<void(float)>& fn) override
+    {
+        onStep = fn;
+    }
+
+    float getStepTime() const override
+    {
+        return stepTime;
+    }
+
+    float getInterpolationAlpha() const override
+    {
+        return std::min(accumulator / stepTime, 1.0f);
+    }
+
+    glm::vec3 getInterpolatedPosition(const JPH::BodyID body) const override
+    {
+        const JPH::RVec3 position = physicsSystem.GetBodyInterfaceNoLock().GetPosition(body);
+        const uint32_t index = body.GetIndex();
+        // the slot may be left over from a removed body with the same index
+        if (previousSteps[index] != stepCount || previousBodies[index] != body)
+        {
+            return jph_to_glm(position);
+        }
+        return jph_to_glm(previousPositions[index] + (position - previousPositions[index]) * getInterpolationAlpha());
     }
 
     void updateCharacter(JPH::CharacterVirtual& character, const float deltaTime) override
     {
+        const auto startTime = std::chrono::steady_clock::now();
         character.ExtendedUpdate(deltaTime, physicsSystem.GetGravity(),
                 JPH::CharacterVirtual::ExtendedUpdateSettings(),
                 JPH::DefaultBroadPhaseLayerFilter(objectVsBroadPhaseLayerFilter, 1),
                 JPH::DefaultObjectLayerFilter(objectLayerFilter.filter, 1),
                 {}, {}, tempAllocator);
+        characterTime += getMilliseconds(startTime, std::chrono::steady_clock::now());
     }
 
     void setOnCollisionEnter(const std::function<void(JPH::BodyID, JPH::BodyID)>& fn) override
@@ -325,9 +536,145 @@ struct PhysicsWorld final :
         }
         return {};
     }
+
+    fff::PhysicsMemoryStats getMemoryStats() const override
+    {
+        return tempAllocator.getStats();
+    }
+
+    void saveState(std::vector<uint8_t>& data, std::span<const JPH::CharacterBase* const> characters) const override
+    {
+        JPH::StateRecorderImpl stream;
+        physicsSystem.SaveState(stream);
+        contactListener.SaveState(stream);
+        for (const JPH::CharacterBase* character : characters)
+        {
+            character->SaveState(stream);
+        }
+        stream.Write(accumulator);
+
+        const std::string bytes = stream.GetData();
+        data.assign(bytes.begin(), bytes.end());
+    }
+
+    bool restoreState(std::span<const uint8_t> data, std::span<JPH::CharacterBase* const> characters) override
+    {
+        JPH::StateRecorderImpl stream;
+        stream.WriteBytes(data.data(), data.size());
+        stream.Rewind();
+
+        if (!physicsSystem.RestoreState(stream) || !contactListener.RestoreState(stream))
+        {
+            return false;
+        }
+        for (JPH::CharacterBase* character : characters)
+        {
+            character->RestoreState(stream);
+        }
+        stream.Read(accumulator);
+
+        // nothing to blend from, and cached rays may have been cast against the old state
+        ++stepCount;
+        invalidateRayCache();
+
+        return !stream.IsFailed();
+    }
+
+    fff::RayHit castRayUncached(const fff::RayQuery& ray) const
+    {
+        const JPH::RRayCast raycast(glm_to_jph(ray.origin), glm_to_jph(ray.direction));
+        JPH::RayCastResult result;
+        if (!physicsSystem.GetNarrowPhaseQuery().CastRay(raycast, result, BroadPhaseLayerMaskFilter(ray.broadPhaseLayers)))
+        {
+            return fff::RayHit { .hit = false, .fraction = 1.0f, .body = JPH::BodyID::cInvalidBodyID, .normal = glm::vec3(0) };
+        }
+
+        glm::vec3 normal = -glm::normalize(ray.direction);
+        JPH::BodyLockRead lock(physicsSystem.GetBodyLockInterface(), result.mBodyID);
+        if (lock.Succeeded())
+        {
+            normal = jph_to_glm(lock.GetBody().GetWorldSpaceSurfaceNormal(result.mSubShapeID2, raycast.GetPointOnRay(result.mFraction)));
+        }
+        return fff::RayHit { .hit = true, .fraction = result.mFraction, .body = result.mBodyID.GetIndexAndSequenceNumber(), .normal = normal };
+    }
+
+    void castRays(std::span<const fff::RayQuery> rays, std::span<fff::RayHit> hits) override
+    {
+        uncachedRays.clear();
+        for (uint32_t i = 0; i < rays.size(); ++i)
+        {
+            // a body removed since the ray was cached would still block it otherwise
+            const CachedRay* cached = rayCache.find(getRayKey(rays[i]));
+            if (cached && isSameRay(cached->ray, rays[i])
+                    && (!cached->hit.hit || physicsSystem.GetBodyInterface().IsAdded(JPH::BodyID(cached->hit.body))))
+            {
+                hits[i] = cached->hit;
+            }
+            else
+            {
+                uncachedRays.push_back(i);
+            }
+        }
+
+        const auto castRange = [&](const uint32_t begin, const uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                hits[uncachedRays[i]] = castRayUncached(rays[uncachedRays[i]]);
+            }
+        };
+
+        if (uncachedRays.size() <= RAYS_PER_JOB)
+        {
+            castRange(0, uncachedRays.size());
+        }
+        else
+        {
+            JPH::JobSystem::Barrier* barrier = jobSystem.CreateBarrier();
+            for (uint32_t begin = 0; begin < uncachedRays.size(); begin += RAYS_PER_JOB)
+            {
+                const uint32_t end = std::min<uint32_t>(begin + RAYS_PER_JOB, uncachedRays.size());
+                barrier->AddJob(jobSystem.CreateJob("CastRays", JPH::Color::sGreen, [&castRange, begin, end] { castRange(begin, end); }));
+            }
+            jobSystem.WaitForJobs(barrier);
+            jobSystem.DestroyBarrier(barrier);
+        }
+
+        for (const uint32_t i : uncachedRays)
+        {
+            // a colliding key just keeps the older ray, a stale one is replaced
+            const uint64_t key = getRayKey(rays[i]);
+            if (CachedRay* cached = rayCache.find(key))
+            {
+                if (isSameRay(cached->ray, rays[i]))
+                {
+                    cached->hit = hits[i];
+                }
+            }
+            else
+            {
+                rayCache.insert(key, CachedRay { .ray = rays[i], .hit = hits[i] });
+            }
+        }
+    }
+
+    void invalidateRayCache() override
+    {
+        rayCache.clear();
+    }
 };
 
-fff::PhysicsWorldInterface* fff::createPhysicsWorld()
+JPH::JobSystem* fff::createJobSystem(uint32_t workerCount)
+{
+    initializeJolt();
+    if (workerCount == 0)
+    {
+        workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+    return new JPH::JobSystemThreadPool(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, static_cast<int>(workerCount));
+}
+
+fff::PhysicsWorldInterface* fff::createPhysicsWorld(JPH::JobSystem& jobSystem, const PhysicsWorldSettings& settings)
 {
-    return new PhysicsWorld;
+    return new PhysicsWorld(jobSystem, settings);
 }
@@ -1,10 +1,15 @@
 #pragma once
 
+#include <cstdint>
+#include <span>
 #include <vector>
+#include <glm/vec3.hpp>
 
 namespace JPH
 {
+    class CharacterBase;
     class CharacterVirtual;
+    class JobSystem;
     class PhysicsSystem;
     class BodyID;
     class SubShapeIDPair;
@@ -18,21 +23,133 @@ namespace std
 
 namespace fff
 {
+    struct PhysicsWorldSettings
+    {
+        uint32_t maxBodies = 65536;
+        // 0 picks Jolt's default
+        uint32_t numBodyMutexes = 0;
+        uint32_t maxBodyPairs = 65536;
+        uint32_t maxContactConstraints = 10240;
+        // preallocated scratch memory for each update, overflow falls back to malloc
+        uint32_t tempAllocatorSize = 16 * 1024 * 1024;
+        // subdivides each update, fast bodies tunnel less but collision detection runs once per step
+        int collisionSteps = 1;
+        // fixed simulation rate, frame time is accumulated and simulated in whole steps
+        float stepRate = 60.0f;
+        // steps per update at most, time beyond that after a hitch is dropped
+        uint32_t maxSubsteps = 4;
+    };
+
+    struct RayQuery
+    {
+        glm::vec3 origin;
+        // the ray's length is the length of its direction
+        glm::vec3 direction;
+        // one bit per broadphase layer, static geometry only by default
+        uint32_t broadPhaseLayers = 1;
+    };
+
+    struct RayHit
+    {
+        bool hit;
+        // along the direction, 1 when nothing was hit
+        float fraction;
+        // JPH::BodyID value of the body hit
+        uint32_t body;
+        // surface normal at the hit point
+        glm::vec3 normal;
+    };
+
+    struct PhysicsMemoryStats
+    {
+        uint32_t tempAllocatorSize;
+        // most scratch memory in use at once, including allocations that overflowed to malloc
+        uint32_t peakTempUsage;
+        uint32_t tempOverflowCount;
+    };
+
+    // one fixed step. times are wall clock milliseconds
+    struct PhysicsStepStats
+    {
+        uint64_t step;
+        // Jolt's update, collision detection and the solver
+        float updateTime;
+        // merging contact events and running the collision and step callbacks
+        float callbackTime;
+        // character updates during the step callback, part of the callback time
+        float characterTime;
+        uint32_t activeBodies;
+        // body pairs and sub-shape pairs in contact, as the contact listener tracks them from Jolt's callbacks
+        uint32_t touchingBodyPairs;
+        uint32_t touchingSubShapePairs;
+        // contact added, persisted and removed callbacks from the update
+        uint32_t contactEvents;
+        // contact constraints Jolt created in the update, one per non-sensor manifold touching a dynamic body
+        uint32_t contactConstraints;
+        uint32_t peakTempUsage;
+    };
+
     struct PhysicsWorldInterface
     {
         virtual ~PhysicsWorldInterface() = default;
 
         virtual JPH::PhysicsSystem& getPhysicsSystem() = 0;
 
+        // runs as many fixed steps as the accumulated time allows, calling the step callback after each
         virtual void update(const float deltaTime) = 0;
 
+        virtual void setOnStep(const std::function<void(float)>& fn) = 0;
+
+        virtual float getStepTime() const = 0;
+
+        // fraction of a step the accumulated time is past the last one, for blending the last two steps
+        virtual float getInterpolationAlpha() const = 0;
+
+        // position blended between the last two steps for rendering
+        virtual glm::vec3 getInterpolatedPosition(const JPH::BodyID body) const = 0;
+
         virtual void updateCharacter(JPH::CharacterVirtual& character, const float deltaTime) = 0;
 
         virtual void setOnCollisionEnter(const std::function<void(JPH::BodyID, JPH::BodyID)> &fn) = 0;
         virtual void setOnCollisionExit(const std::function<void(JPH::BodyID, JPH::BodyID)> &fn) = 0;
 
         virtual std::vector<std::pair<JPH::SubShapeIDPair, JPH::ContactManifold>> getContacts(const JPH::BodyID body0, const JPH::BodyID body1) const = 0;
+
+        virtual PhysicsMemoryStats getMemoryStats() const = 0;
+
+        // stats of the most recent step, all zero before the first
+        virtual const PhysicsStepStats& getStepStats() const = 0;
+
+        // up to the last few seconds of steps, oldest first. with LD57_PHYSICS_STATS set to a file path every
+        // step of every world in the process is also appended there as a CSV row, tagged with the world's number.
+        // the file rolls over to <path>.1 every 10 minutes or so of steps
+        virtual void getStepStatsHistory(std::vector<PhysicsStepStats>& stats) const = 0;
+
+        // the bodies, the contact pair table and the given characters, in a binary blob that replaces data.
+        // restoring needs the same bodies to exist and the same characters in the same order. it fails if the
+        // blob doesn't match, leaving the world partly restored
+        virtual void saveState(std::vector<uint8_t>& data, std::span<const JPH::CharacterBase* const> characters = {}) const = 0;
+        virtual bool restoreState(std::span<const uint8_t> data, std::span<JPH::CharacterBase* const> characters = {}) = 0;
+
+        // closest hit for each ray, spread across the job system when there are many. results are cached until
+        // the next update or step, so repeating a ray in the same frame is free. cached hits on bodies removed since
+        // are cast again
+        virtual void castRays(std::span<const RayQuery> rays, std::span<RayHit> hits) = 0;
+
+        // drops the cached ray results, for bodies added outside a step that earlier rays in the frame should see
+        virtual void invalidateRayCache() = 0;
+
+        RayHit castRay(const RayQuery& ray)
+        {
+            RayHit hit;
+            castRays({ &ray, 1 }, { &hit, 1 });
+            return hit;
+        }
     };
 
-    PhysicsWorldInterface* createPhysicsWorld();
+    // the job system is owned by the caller and can be shared by several worlds and other work.
+    // workerCount 0 uses one worker per hardware thread besides the calling one
+    JPH::JobSystem* createJobSystem(uint32_t workerCount = 0);
+
+    PhysicsWorldInterface* createPhysicsWorld(JPH::JobSystem& jobSystem, const PhysicsWorldSettings& settings = {});
 }
@@ -0,0 +1,191 @@
+#include "projectiles.hpp"
+#include "jph_glm_convert.hpp"
+
+#include <Jolt/Physics/PhysicsSystem.h>
+#include <algorithm>
+
+using fff::Projectiles;
+
+// slab test, fraction of the segment where it enters the box
+static bool intersectSegmentBox(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& min, const glm::vec3& max, float& fraction)
+{
+    float enter = 0.0f;
+    float exit = 1.0f;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (direction[axis] == 0.0f)
+        {
+            if (origin[axis] < min[axis] || origin[axis] > max[axis])
+            {
+                return false;
+            }
+            continue;
+        }
+
+        float t0 = (min[axis] - origin[axis]) / direction[axis];
+        float t1 = (max[axis] - origin[axis]) / direction[axis];
+        if (t0 > t1)
+        {
+            std::swap(t0, t1);
+        }
+        enter = std::max(enter, t0);
+        exit = std::min(exit, t1);
+        if (enter > exit)
+        {
+            return false;
+        }
+    }
+
+    fraction = enter;
+    return true;
+}
+
+Projectiles::Projectiles(const uint32_t capacity, const float radius, const float maxAge) :
+    capacity(capacity),
+    radius(radius),
+    maxAge(maxAge)
+{
+    positions.reserve(capacity);
+    previousPositions.reserve(capacity);
+    velocities.reserve(capacity);
+    angles.reserve(capacity);
+    ages.reserve(capacity);
+    flags.reserve(capacity);
+    rays.reserve(capacity);
+    rayHits.reserve(capacity);
+    removed.reserve(capacity);
+}
+
+bool Projectiles::spawn(const glm::vec3& position, const glm::vec3& velocity, const float angle, const uint32_t flags)
+{
+    if (positions.size() == capacity)
+    {
+        return false;
+    }
+
+    positions.push_back(position);
+    previousPositions.push_back(position);
+    velocities.push_back(velocity);
+    angles.push_back(angle);
+    ages.push_back(0.0f);
+    this->flags.push_back(flags);
+    return true;
+}
+
+void Projectiles::remove(const uint32_t index)
+{
+    const auto swapRemove = [index](auto& values)
+    {
+        values[index] = values.back();
+        values.pop_back();
+    };
+    swapRemove(positions);
+    swapRemove(previousPositions);
+    swapRemove(velocities);
+    swapRemove(angles);
+    swapRemove(ages);
+    swapRemove(flags);
+}
+
+void Projectiles::step(PhysicsWorldInterface& physicsWorld, const float stepTime, const uint32_t broadPhaseLayers,
+        std::span<const Target> targets, std::vector<Hit>& hits)
+{
+    // semi-implicit euler like Jolt's bodies
+    const glm::vec3 gravity = jph_to_glm(physicsWorld.getPhysicsSystem().GetGravity());
+    rays.clear();
+    for (uint32_t i = 0; i < positions.size(); ++i)
+    {
+        velocities[i] += gravity * stepTime;
+        rays.push_back(RayQuery {
+                .origin = positions[i],
+                .direction = velocities[i] * stepTime,
+                .broadPhaseLayers = broadPhaseLayers,
+            });
+    }
+    rayHits.resize(rays.size());
+    physicsWorld.castRays(rays, rayHits);
+
+    removed.assign(positions.size(), false);
+    for (uint32_t i = 0; i < positions.size(); ++i)
+    {
+        const RayQuery& ray = rays[i];
+        const RayHit& rayHit = rayHits[i];
+
+        // the closest of the world hit and any target in front of it
+        float fraction = rayHit.hit ? rayHit.fraction : 1.0f;
+        uint32_t target = NO_TARGET;
+        for (uint32_t j = 0; j < targets.size(); ++j)
+        {
+            float targetFraction;
+            if ((targets[j].flags & flags[i]) && intersectSegmentBox(ray.origin, ray.direction, targets[j].min, targets[j].max, targetFraction)
+                    && targetFraction <= fraction)
+            {
+                fraction = targetFraction;
+                target = j;
+            }
+        }
+
+        previousPositions[i] = positions[i];
+        positions[i] += fraction * ray.direction;
+        ages[i] += stepTime;
+
+        if (target != NO_TARGET || rayHit.hit)
+        {
+            hits.push_back(Hit {
+                    .position = positions[i],
+                    .normal = target != NO_TARGET ? -glm::normalize(ray.direction) : rayHit.normal,
+                    .body = target != NO_TARGET ? UINT32_MAX : rayHit.body,
+                    .target = target,
+                    .flags = flags[i],
+                });
+            removed[i] = true;
+        }
+        else if (ages[i] >= maxAge)
+        {
+            removed[i] = true;
+        }
+    }
+
+    // closest approach of each pair over the step, moving together. only a few hundred exist at most
+    const float minDistance2 = 4.0f * radius * radius;
+    for (uint32_t i = 0; i < positions.size(); ++i)
+    {
+        for (uint32_t j = i + 1; j < positions.size() && !removed[i]; ++j)
+        {
+            if (removed[j])
+            {
+                continue;
+            }
+
+            const glm::vec3 offset = previousPositions[i] - previousPositions[j];
+            const glm::vec3 motion = (positions[i] - previousPositions[i]) - (positions[j] - previousPositions[j]);
+            const float motion2 = glm::dot(motion, motion);
+            const float t = motion2 > 0.0f ? glm::clamp(-glm::dot(offset, motion) / motion2, 0.0f, 1.0f) : 0.0f;
+            const glm::vec3 closest = offset + t * motion;
+            if (glm::dot(closest, closest) <= minDistance2)
+            {
+                removed[i] = true;
+                removed[j] = true;
+            }
+        }
+    }
+
+    // back to front so swapped in projectiles have already been looked at
+    for (uint32_t i = static_cast<uint32_t>(positions.size()); i-- > 0;)
+    {
+        if (removed[i])
+        {
+            remove(i);
+        }
+    }
+}
+
+void Projectiles::clear()
+{
+    positions.clear();
+    previousPositions.clear();
+    velocities.clear();
+    angles.clear();
+    ages.clear();
+    flags.clear();
+}
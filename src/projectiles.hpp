@@ -0,0 +1,92 @@
+#pragma once
+
+#include "physics.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace fff
+{
+    // Projectiles simulated outside the rigid body solver. Each step sweeps a ray along every projectile's
+    // velocity against the physics world (one batched query for all of them) and against a few boxes for
+    // things that aren't bodies, like the player character. They fall under the world's gravity and knock each
+    // other out like the dynamic bodies they replace. Storage is parallel arrays sized once, removing a
+    // projectile moves the last one into its place.
+    class Projectiles
+    {
+    public:
+        // boxes a projectile hits when their flags share a bit with the projectile's
+        struct Target
+        {
+            glm::vec3 min;
+            glm::vec3 max;
+            uint32_t flags;
+        };
+
+        struct Hit
+        {
+            glm::vec3 position;
+            glm::vec3 normal;
+            // JPH::BodyID value, invalid when a target was hit
+            uint32_t body;
+            // index into the targets, UINT32_MAX when a body was hit
+            uint32_t target;
+            uint32_t flags;
+        };
+
+        static constexpr uint32_t NO_TARGET = UINT32_MAX;
+
+    private:
+        const uint32_t capacity;
+        const float radius;
+        const float maxAge;
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> previousPositions;
+        std::vector<glm::vec3> velocities;
+        std::vector<float> angles;
+        std::vector<float> ages;
+        std::vector<uint32_t> flags;
+
+        // per step scratch
+        std::vector<RayQuery> rays;
+        std::vector<RayHit> rayHits;
+        std::vector<uint8_t> removed;
+
+        void remove(const uint32_t index);
+
+    public:
+        explicit Projectiles(const uint32_t capacity, const float radius, const float maxAge);
+
+        // false when the pool is full
+        bool spawn(const glm::vec3& position, const glm::vec3& velocity, const float angle, const uint32_t flags);
+
+        // projectiles that hit something or outlived maxAge are removed, hits are appended. projectiles that
+        // pass within two radii of each other are removed too, without a hit
+        void step(PhysicsWorldInterface& physicsWorld, const float stepTime, const uint32_t broadPhaseLayers,
+                std::span<const Target> targets, std::vector<Hit>& hits);
+
+        void clear();
+
+        uint32_t size() const
+        {
+            return static_cast<uint32_t>(positions.size());
+        }
+
+        glm::vec3 getInterpolatedPosition(const uint32_t index, const float alpha) const
+        {
+            return glm::mix(previousPositions[index], positions[index], alpha);
+        }
+
+        float getAngle(const uint32_t index) const
+        {
+            return angles[index];
+        }
+
+        uint32_t getFlags(const uint32_t index) const
+        {
+            return flags[index];
+        }
+    };
+}
@@ -371,7 +371,25 @@ static vk::raii::DescriptorSet createDescriptorSet(const vk::raii::Device& devic
             }).front());
 }
 
-static vk::raii::DescriptorSet createTextureDescriptorSet(const vk::raii::Device& device, const vk::DescriptorPool& descriptorPool, const vk::DescriptorSetLayout& descriptorSetLayout, const vk::Sampler& textureSampler, const std::vector<std::tuple<vma::UniqueImage, vma::UniqueAllocation, vk::raii::ImageView>>& textures)
+// magnification stays nearest to keep the pixel art crisp, minification uses the mip chain. Atlas pages and
+// glyph sheets use the plain nearest sampler instead, linear or anisotropic taps would reach into their neighbours
+static vk::raii::Sampler createMaterialSampler(const vk::raii::Device& device, const float maxSamplerAnisotropy)
+{
+    return vk::raii::Sampler(device, vk::SamplerCreateInfo {
+            .magFilter = vk::Filter::eNearest,
+            .minFilter = vk::Filter::eLinear,
+            .mipmapMode = vk::SamplerMipmapMode::eLinear,
+            .addressModeU = vk::SamplerAddressMode::eRepeat,
+            .addressModeV = vk::SamplerAddressMode::eRepeat,
+            .addressModeW = vk::SamplerAddressMode::eRepeat,
+            .anisotropyEnable = maxSamplerAnisotropy > 1.0f ? vk::True : vk::False,
+            .maxAnisotropy = std::min(maxSamplerAnisotropy, 8.0f),
+            .minLod = 0.0f,
+            .maxLod = VK_LOD_CLAMP_NONE,
+        });
+}
+
+static vk::raii::DescriptorSet createTextureDescriptorSet(const vk::raii::Device& device, const vk::DescriptorPool& descriptorPool, const vk::DescriptorSetLayout& descriptorSetLayout, const vk::Sampler& textureSampler, const vk::Sampler& singleLevelSampler, const std::vector<std::tuple<vma::UniqueImage, vma::UniqueAllocation, vk::raii::ImageView>>& textures, const std::vector<uint32_t>& singleLevelTextures)
 {
     auto descriptorSet = createDescriptorSet(device, descriptorPool, descriptorSetLayout);
 
@@ -385,6 +403,10 @@ static vk::raii::DescriptorSet createTextureDescriptorSet(const vk::raii::Device
                 .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
             });
     }
+    for (const uint32_t index : singleLevelTextures)
+    {
+        imageInfos[index].sampler = singleLevelSampler;
+    }
 
     device.updateDescriptorSets(vk::WriteDescriptorSet {
             .dstSet = descriptorSet,
@@ -973,7 +995,7 @@ void GBuffer::recreate(const vk::raii::Device& device, const vma::Allocator& all
         });
 }
 
-Renderer::Renderer(const vk::raii::Device& device, const vk::raii::Queue& queue, const uint32_t queueFamilyIndex, const vma::Allocator& allocator, const std::vector<Texture>& textures, const vk::Buffer geometryVertexBuffer, const vk::Buffer geometryIndexBuffer, const uint32_t numFramesInFlight, const vk::Format colorAttachmentFormat, const vk::Format depthAttachmentFormat, const vk::Extent2D& framebufferExtent, const uint32_t minUniformBufferOffsetAlignment) :
+Renderer::Renderer(const vk::raii::Device& device, const vk::raii::Queue& queue, const uint32_t queueFamilyIndex, const vma::Allocator& allocator, const std::vector<Texture>& textures, const std::vector<uint32_t>& singleLevelTextures, const vk::Buffer geometryVertexBuffer, const vk::Buffer geometryIndexBuffer, const uint32_t numFramesInFlight, const vk::Format colorAttachmentFormat, const vk::Format depthAttachmentFormat, const vk::Extent2D& framebufferExtent, const uint32_t minUniformBufferOffsetAlignment, const float maxSamplerAnisotropy) :
     device(device),
     queue(queue),
     allocator(allocator),
@@ -982,6 +1004,7 @@ Renderer::Renderer(const vk::raii::Device& device, const vk::raii::Queue& queue,
     geometryIndexBuffer(geometryIndexBuffer),
     decalGeometryBuffer(createDecalGeometryBuffer(device, queue, queueFamilyIndex, allocator)),
     textureSampler(device, vk::SamplerCreateInfo {}),
+    materialSampler(createMaterialSampler(device, maxSamplerAnisotropy)),
     descriptorPool(createDescriptorPool(device, textures.size(), numFramesInFlight)),
     uniformBufferAlignedSizeVertex(minUniformBufferOffsetAlignment * ((UniformBlockSize::VertexShader - 1) / minUniformBufferOffsetAlignment + 1)),
     uniformBufferAlignedSizeFragment(minUniformBufferOffsetAlignment * ((UniformBlockSize::FragmentShader - 1) / minUniformBufferOffsetAlignment + 1)),
@@ -1085,8 +1108,10 @@ Renderer::Renderer(const vk::raii::Device& device, const vk::raii::Queue& queue,
     descriptorSets {
         .textureArray = createTextureDescriptorSet(device, descriptorPool,
                 descriptorSetLayouts[DescriptorSetLayoutIDs::BindlessTextureArray],
+                materialSampler,
                 textureSampler,
-                textures),
+                textures,
+                singleLevelTextures),
         .gBuffer = createGBufferDescriptorSet(device, descriptorPool,
                 descriptorSetLayouts[DescriptorSetLayoutIDs::GBuffer],
                 textureSampler,
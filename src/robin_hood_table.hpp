@@ -0,0 +1,255 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace fff
+{
+    // Open addressing hash table from 64 bit keys to small trivially copyable values. Robin Hood probing keeps
+    // probe lengths short and lets lookups stop early, erasing shifts the following entries back instead of
+    // leaving tombstones. Growing doesn't rehash everything at once: the old slots are moved a few at a time by
+    // later inserts and erases, and lookups check both tables until the move is done.
+    template<typename Value>
+    class RobinHoodTable
+    {
+        static_assert(std::is_trivially_copyable_v<Value>);
+
+        static constexpr size_t MIN_CAPACITY = 64;
+        // old slots moved per insert or erase while growing, enough to finish well before the new table fills up
+        static constexpr size_t MIGRATE_STEP = 8;
+
+        struct Slot
+        {
+            uint64_t key;
+            Value value;
+            // 0 for an empty slot, otherwise 1 + distance from the key's home slot
+            uint32_t distance;
+        };
+
+        std::vector<Slot> slots;
+        std::vector<Slot> oldSlots;
+        size_t migrateIndex = 0;
+        size_t count = 0;
+
+        static uint64_t hashKey(uint64_t key)
+        {
+            // splitmix64 finalizer
+            key ^= key >> 30;
+            key *= 0xbf58476d1ce4e5b9ull;
+            key ^= key >> 27;
+            key *= 0x94d049bb133111ebull;
+            key ^= key >> 31;
+            return key;
+        }
+
+        static Slot* findSlot(std::vector<Slot>& table, const uint64_t key)
+        {
+            if (table.empty())
+            {
+                return nullptr;
+            }
+
+            const size_t mask = table.size() - 1;
+            size_t index = hashKey(key) & mask;
+            for (uint32_t distance = 1; distance <= table[index].distance; ++distance)
+            {
+                if (table[index].key == key)
+                {
+                    return &table[index];
+                }
+                index = (index + 1) & mask;
+            }
+            return nullptr;
+        }
+
+        static void insertSlot(std::vector<Slot>& table, Slot slot)
+        {
+            const size_t mask = table.size() - 1;
+            size_t index = hashKey(slot.key) & mask;
+            slot.distance = 1;
+            while (table[index].distance != 0)
+            {
+                // take from the rich: whoever is closer to home moves on
+                if (table[index].distance < slot.distance)
+                {
+                    std::swap(table[index], slot);
+                }
+                index = (index + 1) & mask;
+                ++slot.distance;
+            }
+            table[index] = slot;
+        }
+
+        // in the table being drained the shift stops at slots before migratedEnd, those wrapped around from the end
+        // have been moved already and must not come back as unmigrated
+        static void eraseSlot(std::vector<Slot>& table, Slot* slot, const size_t migratedEnd = 0)
+        {
+            const size_t mask = table.size() - 1;
+            size_t index = slot - table.data();
+            size_t next = (index + 1) & mask;
+            while (table[next].distance > 1 && next >= migratedEnd)
+            {
+                table[index] = table[next];
+                --table[index].distance;
+                index = next;
+                next = (next + 1) & mask;
+            }
+            table[index] = Slot{};
+        }
+
+        void migrate(const size_t slotCount)
+        {
+            const size_t end = std::min(oldSlots.size(), migrateIndex + slotCount);
+            for (; migrateIndex < end; ++migrateIndex)
+            {
+                const Slot& slot = oldSlots[migrateIndex];
+                if (slot.distance != 0)
+                {
+                    insertSlot(slots, slot);
+                }
+            }
+
+            if (migrateIndex == oldSlots.size())
+            {
+                oldSlots = {};
+                migrateIndex = 0;
+            }
+        }
+
+        // entries in the old table before the migration point have been moved already
+        Slot* findOld(const uint64_t key)
+        {
+            Slot* slot = findSlot(oldSlots, key);
+            if (!slot || static_cast<size_t>(slot - oldSlots.data()) < migrateIndex)
+            {
+                return nullptr;
+            }
+            return slot;
+        }
+
+        void grow()
+        {
+            // a second growth can't start until the first one has drained
+            migrate(oldSlots.size());
+            oldSlots = std::move(slots);
+            slots.assign(std::max(MIN_CAPACITY, oldSlots.size() * 2), Slot{});
+            migrateIndex = 0;
+        }
+
+    public:
+        // probe lengths of the entries in the table, 1 for an entry in its home slot. entries still waiting in
+        // the old table count with the length they have there
+        struct ProbeStats
+        {
+            double meanLength;
+            uint32_t maxLength;
+            size_t capacity;
+        };
+
+        size_t size() const
+        {
+            return count;
+        }
+
+        ProbeStats getProbeStats() const
+        {
+            ProbeStats stats { .meanLength = 0.0, .maxLength = 0, .capacity = slots.size() };
+            uint64_t totalLength = 0;
+            const auto addSlot = [&](const Slot& slot)
+            {
+                totalLength += slot.distance;
+                stats.maxLength = std::max(stats.maxLength, slot.distance);
+            };
+            for (const Slot& slot : slots)
+            {
+                if (slot.distance != 0)
+                {
+                    addSlot(slot);
+                }
+            }
+            for (size_t i = migrateIndex; i < oldSlots.size(); ++i)
+            {
+                if (oldSlots[i].distance != 0)
+                {
+                    addSlot(oldSlots[i]);
+                }
+            }
+            stats.meanLength = count > 0 ? static_cast<double>(totalLength) / count : 0.0;
+            return stats;
+        }
+
+        // keeps the slots allocated
+        void clear()
+        {
+            std::fill(slots.begin(), slots.end(), Slot{});
+            oldSlots = {};
+            migrateIndex = 0;
+            count = 0;
+        }
+
+        Value* find(const uint64_t key)
+        {
+            if (Slot* slot = findSlot(slots, key))
+            {
+                return &slot->value;
+            }
+            if (Slot* slot = findOld(key))
+            {
+                return &slot->value;
+            }
+            return nullptr;
+        }
+
+        const Value* find(const uint64_t key) const
+        {
+            return const_cast<RobinHoodTable*>(this)->find(key);
+        }
+
+        // the key must not be in the table already
+        void insert(const uint64_t key, const Value& value)
+        {
+            // grow at 3/4 load
+            if (4 * (count + 1) > 3 * slots.size())
+            {
+                grow();
+            }
+            else if (!oldSlots.empty())
+            {
+                migrate(MIGRATE_STEP);
+            }
+
+            insertSlot(slots, Slot {
+                    .key = key,
+                    .value = value,
+                    .distance = 1,
+                });
+            ++count;
+        }
+
+        bool erase(const uint64_t key)
+        {
+            if (Slot* slot = findSlot(slots, key))
+            {
+                eraseSlot(slots, slot);
+            }
+            else if (Slot* slot = findOld(key))
+            {
+                eraseSlot(oldSlots, slot, migrateIndex);
+            }
+            else
+            {
+                return false;
+            }
+
+            --count;
+            if (!oldSlots.empty())
+            {
+                migrate(MIGRATE_STEP);
+            }
+            return true;
+        }
+    };
+}
@@ -0,0 +1,191 @@
+#include "sprite_atlas.hpp"
+#include "baked_texture.hpp"
+#include "loader_utility.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+using eng::SpriteAtlas;
+
+static uint32_t alignUp(const uint32_t value, const uint32_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+SpriteAtlas::SpriteAtlas(const vk::raii::Device& device, const vma::Allocator& allocator, LoaderUtility& loaderUtility, std::vector<Texture>& textures, std::vector<uint32_t>& singleLevelTextures) :
+    device(device),
+    allocator(allocator),
+    loaderUtility(loaderUtility),
+    textures(textures),
+    singleLevelTextures(singleLevelTextures)
+{
+}
+
+SpriteAtlas::Page& SpriteAtlas::createPage(const vk::Format format)
+{
+    auto [image, allocation] = allocator.createImageUnique(vk::ImageCreateInfo {
+            .imageType = vk::ImageType::e2D,
+            .format = format,
+            .extent = vk::Extent3D{ PAGE_SIZE, PAGE_SIZE, 1 },
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst,
+            .initialLayout = vk::ImageLayout::eUndefined,
+        }, vma::AllocationCreateInfo {
+            .usage = vma::MemoryUsage::eAuto,
+        });
+
+    const vk::ImageSubresourceRange subresourceRange { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+
+    const vk::ImageMemoryBarrier2 initialImageMemoryBarrier {
+        .srcStageMask = vk::PipelineStageFlagBits2::eTopOfPipe,
+        .srcAccessMask = {},
+        .dstStageMask = vk::PipelineStageFlagBits2::eTransfer,
+        .dstAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        .oldLayout = vk::ImageLayout::eUndefined,
+        .newLayout = vk::ImageLayout::eTransferDstOptimal,
+        .image = *image,
+        .subresourceRange = subresourceRange,
+    };
+
+    loaderUtility.commandBuffer.pipelineBarrier2(vk::DependencyInfo {
+            .imageMemoryBarrierCount = 1,
+            .pImageMemoryBarriers = &initialImageMemoryBarrier,
+        });
+
+    // the space between sprites must read as transparent
+    if (format == vk::Format::eBc1RgbaSrgbBlock)
+    {
+        // compressed images can't be cleared, fill with 3-color blocks that select the transparent index
+        const vk::DeviceSize size = getBC1Size(PAGE_SIZE, PAGE_SIZE);
+        auto& [stagingBuffer, stagingBufferAllocation, allocationInfo] = loaderUtility.createStagingBuffer(size);
+        const uint8_t transparentBlock[8] = { 0, 0, 0, 0, 0xff, 0xff, 0xff, 0xff };
+        for (vk::DeviceSize offset = 0; offset < size; offset += sizeof(transparentBlock))
+        {
+            std::memcpy(static_cast<char*>(allocationInfo.pMappedData) + offset, transparentBlock, sizeof(transparentBlock));
+        }
+
+        loaderUtility.commandBuffer.copyBufferToImage(*stagingBuffer, *image, vk::ImageLayout::eTransferDstOptimal, vk::BufferImageCopy {
+                .imageSubresource = { vk::ImageAspectFlagBits::eColor, 0, 0, 1 },
+                .imageExtent = vk::Extent3D{ PAGE_SIZE, PAGE_SIZE, 1 },
+            });
+    }
+    else
+    {
+        loaderUtility.commandBuffer.clearColorImage(*image, vk::ImageLayout::eTransferDstOptimal,
+                vk::ClearColorValue(std::array { 0.0f, 0.0f, 0.0f, 0.0f }),
+                subresourceRange);
+    }
+
+    const vk::ImageMemoryBarrier2 clearImageMemoryBarrier {
+        .srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
+        .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eTransfer,
+        .dstAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+        .newLayout = vk::ImageLayout::eTransferDstOptimal,
+        .image = *image,
+        .subresourceRange = subresourceRange,
+    };
+
+    loaderUtility.commandBuffer.pipelineBarrier2(vk::DependencyInfo {
+            .imageMemoryBarrierCount = 1,
+            .pImageMemoryBarriers = &clearImageMemoryBarrier,
+        });
+
+    vk::raii::ImageView imageView(device, vk::ImageViewCreateInfo {
+            .image = *image,
+            .viewType = vk::ImageViewType::e2D,
+            .format = format,
+            .subresourceRange = subresourceRange,
+        });
+
+    const vk::Image imageHandle = *image;
+    const uint32_t textureIndex = textures.size();
+    textures.emplace_back(std::move(image), std::move(allocation), std::move(imageView));
+    singleLevelTextures.push_back(textureIndex);
+
+    return pages.emplace_back(Page {
+            .format = format,
+            .image = imageHandle,
+            .textureIndex = textureIndex,
+            .cursorX = PADDING,
+            .shelfY = PADDING,
+            .shelfHeight = 0,
+        });
+}
+
+std::optional<eng::TextureRegion> SpriteAtlas::addSprite(const char* bytes, const vk::DeviceSize size, const vk::Format format, const vk::Extent2D extent)
+{
+    if (extent.width > MAX_SPRITE_SIZE || extent.height > MAX_SPRITE_SIZE)
+    {
+        return std::nullopt;
+    }
+
+    const uint32_t slotWidth = alignUp(extent.width, ALIGNMENT);
+    const uint32_t slotHeight = alignUp(extent.height, ALIGNMENT);
+
+    const auto fits = [&](Page& page)
+    {
+        if (page.cursorX + slotWidth + PADDING > PAGE_SIZE)
+        {
+            page.shelfY += page.shelfHeight + PADDING;
+            page.cursorX = PADDING;
+            page.shelfHeight = 0;
+        }
+        return page.shelfY + slotHeight + PADDING <= PAGE_SIZE;
+    };
+
+    // only the most recent page of a format has free space left
+    auto it = std::find_if(pages.rbegin(), pages.rend(), [&](const Page& page) { return page.format == format; });
+    Page& page = (it != pages.rend() && fits(*it)) ? *it : createPage(format);
+
+    const uint32_t x = page.cursorX;
+    const uint32_t y = page.shelfY;
+    page.cursorX += slotWidth + PADDING;
+    page.shelfHeight = std::max(page.shelfHeight, slotHeight);
+
+    auto& [stagingBuffer, stagingBufferAllocation, allocationInfo] = loaderUtility.createStagingBuffer(size);
+    std::memcpy(allocationInfo.pMappedData, bytes, size);
+
+    // block compressed copies must cover whole blocks
+    const bool blockCompressed = format == vk::Format::eBc1RgbaSrgbBlock;
+    loaderUtility.commandBuffer.copyBufferToImage(*stagingBuffer, page.image, vk::ImageLayout::eTransferDstOptimal, vk::BufferImageCopy {
+            .imageSubresource = { vk::ImageAspectFlagBits::eColor, 0, 0, 1 },
+            .imageOffset = vk::Offset3D{ static_cast<int32_t>(x), static_cast<int32_t>(y), 0 },
+            .imageExtent = vk::Extent3D{ blockCompressed ? slotWidth : extent.width, blockCompressed ? slotHeight : extent.height, 1 },
+        });
+
+    return TextureRegion {
+        .textureIndex = page.textureIndex,
+        .minTexCoord = glm::vec2(x, y) / static_cast<float>(PAGE_SIZE),
+        .texCoordScale = glm::vec2(extent.width, extent.height) / static_cast<float>(PAGE_SIZE),
+    };
+}
+
+void SpriteAtlas::finalize()
+{
+    std::vector<vk::ImageMemoryBarrier2> imageMemoryBarriers;
+    imageMemoryBarriers.reserve(pages.size());
+    for (const auto& page : pages)
+    {
+        imageMemoryBarriers.push_back(vk::ImageMemoryBarrier2 {
+                .srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
+                .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+                .dstStageMask = vk::PipelineStageFlagBits2::eFragmentShader,
+                .dstAccessMask = vk::AccessFlagBits2::eShaderSampledRead,
+                .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+                .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+                .image = page.image,
+                .subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 },
+            });
+    }
+
+    if (!imageMemoryBarriers.empty())
+    {
+        loaderUtility.commandBuffer.pipelineBarrier2(vk::DependencyInfo {
+                .imageMemoryBarrierCount = static_cast<uint32_t>(imageMemoryBarriers.size()),
+                .pImageMemoryBarriers = imageMemoryBarriers.data(),
+            });
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "common_definitions.hpp"
+#include "engine.hpp"
+#include <optional>
+
+namespace eng
+{
+    struct LoaderUtility;
+
+    // Packs small sprites into shared pages with shelf packing. Pages are added to the texture list as they
+    // are created and stay in TransferDstOptimal until finalize() is recorded before the loader commits.
+    // Pages have a single level and are listed in singleLevelTextures, the padding only guards against
+    // filtering across neighbouring sprites at the top level.
+    struct SpriteAtlas
+    {
+        static constexpr uint32_t PAGE_SIZE = 1024;
+        static constexpr uint32_t MAX_SPRITE_SIZE = 256;
+        // sprite rects start on 4 texel boundaries so block compressed data can be copied in place
+        static constexpr uint32_t ALIGNMENT = 4;
+        static constexpr uint32_t PADDING = 4;
+
+        explicit SpriteAtlas(const vk::raii::Device& device, const vma::Allocator& allocator, LoaderUtility& loaderUtility, std::vector<Texture>& textures, std::vector<uint32_t>& singleLevelTextures);
+
+        // returns nothing if the sprite is too large to share a page
+        std::optional<TextureRegion> addSprite(const char* bytes, const vk::DeviceSize size, const vk::Format format, const vk::Extent2D extent);
+        void finalize();
+
+        struct Page
+        {
+            vk::Format format;
+            vk::Image image;
+            uint32_t textureIndex;
+            uint32_t cursorX;
+            uint32_t shelfY;
+            uint32_t shelfHeight;
+        };
+
+        Page& createPage(const vk::Format format);
+
+        const vk::raii::Device& device;
+        const vma::Allocator& allocator;
+        LoaderUtility& loaderUtility;
+        std::vector<Texture>& textures;
+        std::vector<uint32_t>& singleLevelTextures;
+        std::vector<Page> pages;
+    };
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace eng
+{
+    // Lock-free ring buffer for exactly one producer thread and one consumer thread. Capacity is rounded up to
+    // a power of two; the indices run freely and are masked on access.
+    template<typename T>
+    class SpscRingBuffer
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        const size_t capacity;
+        const size_t mask;
+        const std::unique_ptr<T[]> data;
+        alignas(64) std::atomic<size_t> readIndex = 0;
+        alignas(64) std::atomic<size_t> writeIndex = 0;
+
+        static constexpr size_t roundUpCapacity(const size_t value)
+        {
+            size_t result = 1;
+            while (result < value)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+
+    public:
+        explicit SpscRingBuffer(const size_t minCapacity) :
+            capacity(roundUpCapacity(minCapacity)),
+            mask(capacity - 1),
+            data(new T[capacity])
+        {
+        }
+
+        SpscRingBuffer(const SpscRingBuffer&) = delete;
+        SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+        // producer side
+        size_t writeAvailable() const
+        {
+            return capacity - (writeIndex.load(std::memory_order_relaxed) - readIndex.load(std::memory_order_acquire));
+        }
+
+        size_t write(const T* values, const size_t count)
+        {
+            const size_t write = writeIndex.load(std::memory_order_relaxed);
+            const size_t n = std::min(count, capacity - (write - readIndex.load(std::memory_order_acquire)));
+            const size_t first = std::min(n, capacity - (write & mask));
+            std::copy_n(values, first, data.get() + (write & mask));
+            std::copy_n(values + first, n - first, data.get());
+            writeIndex.store(write + n, std::memory_order_release);
+            return n;
+        }
+
+        bool push(const T& value)
+        {
+            return write(&value, 1) == 1;
+        }
+
+        // consumer side
+        size_t readAvailable() const
+        {
+            return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_relaxed);
+        }
+
+        size_t read(T* values, const size_t count)
+        {
+            const size_t read = readIndex.load(std::memory_order_relaxed);
+            const size_t n = std::min(count, writeIndex.load(std::memory_order_acquire) - read);
+            const size_t first = std::min(n, capacity - (read & mask));
+            std::copy_n(data.get() + (read & mask), first, values);
+            std::copy_n(data.get(), n - first, values + first);
+            readIndex.store(read + n, std::memory_order_release);
+            return n;
+        }
+
+        bool pop(T& value)
+        {
+            return read(&value, 1) == 1;
+        }
+    };
+}
@@ -0,0 +1,201 @@
+#include "baked_texture.hpp"
+#include <stb_image.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+
+using namespace eng;
+
+struct MipLevel
+{
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint8_t> rgba;
+};
+
+static float srgbToLinear(const float value)
+{
+    return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static uint8_t linearToSrgb(const float value)
+{
+    const float srgb = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    return static_cast<uint8_t>(std::clamp(srgb * 255.0f + 0.5f, 0.0f, 255.0f));
+}
+
+// 2x2 box filter in linear space, weighted by alpha so transparent texels don't bleed into the edges
+static MipLevel downsample(const MipLevel& source, const std::array<float, 256>& toLinear)
+{
+    MipLevel result {
+        .width = std::max(source.width / 2, 1u),
+        .height = std::max(source.height / 2, 1u),
+        .rgba = {},
+    };
+    result.rgba.resize(4 * result.width * result.height);
+
+    for (uint32_t y = 0; y < result.height; ++y)
+    {
+        for (uint32_t x = 0; x < result.width; ++x)
+        {
+            float color[3] = { 0, 0, 0 };
+            float alpha = 0;
+            for (uint32_t sy = 2 * y; sy < std::min(2 * y + 2, source.height); ++sy)
+            {
+                for (uint32_t sx = 2 * x; sx < std::min(2 * x + 2, source.width); ++sx)
+                {
+                    const uint8_t* texel = source.rgba.data() + 4 * (sy * source.width + sx);
+                    const float weight = texel[3] / 255.0f;
+                    for (uint32_t c = 0; c < 3; ++c)
+                    {
+                        color[c] += weight * toLinear[texel[c]];
+                    }
+                    alpha += weight;
+                }
+            }
+
+            const uint32_t sampleCount = std::min(2u, source.width) * std::min(2u, source.height);
+            uint8_t* texel = result.rgba.data() + 4 * (y * result.width + x);
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                texel[c] = alpha > 0 ? linearToSrgb(color[c] / alpha) : 0;
+            }
+            texel[3] = static_cast<uint8_t>(alpha / sampleCount * 255.0f + 0.5f);
+        }
+    }
+
+    return result;
+}
+
+// BC1 only keeps alpha as a 1-bit cutout, anything partly transparent would lose its soft edges
+static bool hasPartialAlpha(const MipLevel& level)
+{
+    for (size_t i = 3; i < level.rgba.size(); i += 4)
+    {
+        if (level.rgba[i] != 0 && level.rgba[i] != 255)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    BakedTextureFormat format = BakedTextureFormat::BC1Srgb;
+    std::vector<std::string_view> paths;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view argument = argv[i];
+        if (argument == "--format" && i + 1 < argc)
+        {
+            const std::string_view value = argv[++i];
+            if (value == "bc1")
+            {
+                format = BakedTextureFormat::BC1Srgb;
+            }
+            else if (value == "rgba8")
+            {
+                format = BakedTextureFormat::RGBA8Srgb;
+            }
+            else
+            {
+                std::cerr << "Unknown format: " << value << std::endl;
+                return 1;
+            }
+        }
+        else
+        {
+            paths.push_back(argument);
+        }
+    }
+
+    if (paths.size() != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " [--format bc1|rgba8] <input> <output>\n"
+            << "bc1 is only used for opaque and cutout textures, ones with partial alpha are written as rgba8" << std::endl;
+        return 1;
+    }
+
+    int width, height, components;
+    stbi_uc* imageData = stbi_load(paths[0].data(), &width, &height, &components, 4);
+    if (!imageData)
+    {
+        std::cerr << "Failed to load " << paths[0] << ": " << stbi_failure_reason() << std::endl;
+        return 1;
+    }
+
+    std::vector<MipLevel> levels;
+    levels.push_back(MipLevel {
+            .width = static_cast<uint32_t>(width),
+            .height = static_cast<uint32_t>(height),
+            .rgba = std::vector<uint8_t>(imageData, imageData + 4 * width * height),
+        });
+    stbi_image_free(imageData);
+
+    if (format == BakedTextureFormat::BC1Srgb && hasPartialAlpha(levels.front()))
+    {
+        std::cout << paths[0] << " is alpha blended, baking it uncompressed" << std::endl;
+        format = BakedTextureFormat::RGBA8Srgb;
+    }
+
+    std::array<float, 256> toLinear;
+    for (uint32_t i = 0; i < toLinear.size(); ++i)
+    {
+        toLinear[i] = srgbToLinear(i / 255.0f);
+    }
+
+    while (levels.back().width > 1 || levels.back().height > 1)
+    {
+        levels.push_back(downsample(levels.back(), toLinear));
+    }
+
+    std::vector<BakedTextureLevel> levelRecords;
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> blocks;
+    for (const auto& level : levels)
+    {
+        levelRecords.push_back(BakedTextureLevel {
+                .offset = static_cast<uint32_t>(data.size()),
+                .size = 0,
+                .width = level.width,
+                .height = level.height,
+            });
+
+        if (format == BakedTextureFormat::BC1Srgb)
+        {
+            encodeBC1(level.rgba.data(), level.width, level.height, blocks);
+            data.insert(data.end(), blocks.begin(), blocks.end());
+        }
+        else
+        {
+            data.insert(data.end(), level.rgba.begin(), level.rgba.end());
+        }
+
+        levelRecords.back().size = static_cast<uint32_t>(data.size()) - levelRecords.back().offset;
+    }
+
+    const BakedTextureHeader header {
+        .magic = BAKED_TEXTURE_MAGIC,
+        .version = BAKED_TEXTURE_VERSION,
+        .format = format,
+        .width = static_cast<uint32_t>(width),
+        .height = static_cast<uint32_t>(height),
+        .mipLevels = static_cast<uint32_t>(levels.size()),
+    };
+
+    std::ofstream output(paths[1].data(), std::ios::binary);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char*>(levelRecords.data()), levelRecords.size() * sizeof(BakedTextureLevel));
+    output.write(reinterpret_cast<const char*>(data.data()), data.size());
+    if (!output)
+    {
+        std::cerr << "Failed to write " << paths[1] << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,28 +1,130 @@
 #include "texture_loader.hpp"
 #include "loader_utility.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
 
 using eng::TextureLoader;
 
-TextureLoader::TextureLoader(const vk::raii::Device& device, const vma::Allocator& allocator, LoaderUtility& loaderUtility) :
+TextureLoader::TextureLoader(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice, const vma::Allocator& allocator, LoaderUtility& loaderUtility) :
     device(device),
+    physicalDevice(physicalDevice),
     allocator(allocator),
-    loaderUtility(loaderUtility)
+    loaderUtility(loaderUtility),
+    bc1Supported(physicalDevice.getFeatures().textureCompressionBC
+            && (physicalDevice.getFormatProperties(vk::Format::eBc1RgbaSrgbBlock).optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage))
 {
 }
 
-eng::Texture TextureLoader::loadTexture(const char* bytes, const vk::DeviceSize size, const vk::Format format, const vk::Extent2D extent)
+static uint32_t getMipLevelCount(const vk::Extent2D extent)
+{
+    return static_cast<uint32_t>(std::bit_width(std::max(extent.width, extent.height)));
+}
+
+// expects level 0 in TransferDstOptimal and the remaining levels undefined, leaves every level in ShaderReadOnlyOptimal
+static void generateMipmaps(const vk::raii::CommandBuffer& commandBuffer, const vk::Image image, const vk::Extent2D extent, const uint32_t mipLevels)
+{
+    vk::ImageMemoryBarrier2 barrier {
+        .image = image,
+        .subresourceRange = vk::ImageSubresourceRange {
+            .aspectMask = vk::ImageAspectFlagBits::eColor,
+            .levelCount = 1,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+    };
+
+    int32_t width = extent.width;
+    int32_t height = extent.height;
+    for (uint32_t level = 1; level < mipLevels; ++level)
+    {
+        const int32_t nextWidth = std::max(width / 2, 1);
+        const int32_t nextHeight = std::max(height / 2, 1);
+
+        const vk::ImageMemoryBarrier2 sourceBarrier {
+            .srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
+            .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+            .dstStageMask = vk::PipelineStageFlagBits2::eTransfer,
+            .dstAccessMask = vk::AccessFlagBits2::eTransferRead,
+            .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+            .newLayout = vk::ImageLayout::eTransferSrcOptimal,
+            .image = image,
+            .subresourceRange = { vk::ImageAspectFlagBits::eColor, level - 1, 1, 0, 1 },
+        };
+        const vk::ImageMemoryBarrier2 destinationBarrier {
+            .srcStageMask = vk::PipelineStageFlagBits2::eTopOfPipe,
+            .srcAccessMask = {},
+            .dstStageMask = vk::PipelineStageFlagBits2::eTransfer,
+            .dstAccessMask = vk::AccessFlagBits2::eTransferWrite,
+            .oldLayout = vk::ImageLayout::eUndefined,
+            .newLayout = vk::ImageLayout::eTransferDstOptimal,
+            .image = image,
+            .subresourceRange = { vk::ImageAspectFlagBits::eColor, level, 1, 0, 1 },
+        };
+        const std::array blitBarriers { sourceBarrier, destinationBarrier };
+        commandBuffer.pipelineBarrier2(vk::DependencyInfo {
+                .imageMemoryBarrierCount = static_cast<uint32_t>(blitBarriers.size()),
+                .pImageMemoryBarriers = blitBarriers.data(),
+            });
+
+        commandBuffer.blitImage(image, vk::ImageLayout::eTransferSrcOptimal, image, vk::ImageLayout::eTransferDstOptimal, vk::ImageBlit {
+                .srcSubresource = { vk::ImageAspectFlagBits::eColor, level - 1, 0, 1 },
+                .srcOffsets = std::array { vk::Offset3D{ 0, 0, 0 }, vk::Offset3D{ width, height, 1 } },
+                .dstSubresource = { vk::ImageAspectFlagBits::eColor, level, 0, 1 },
+                .dstOffsets = std::array { vk::Offset3D{ 0, 0, 0 }, vk::Offset3D{ nextWidth, nextHeight, 1 } },
+            }, vk::Filter::eLinear);
+
+        barrier.srcStageMask = vk::PipelineStageFlagBits2::eTransfer;
+        barrier.srcAccessMask = vk::AccessFlagBits2::eTransferRead;
+        barrier.dstStageMask = vk::PipelineStageFlagBits2::eFragmentShader;
+        barrier.dstAccessMask = vk::AccessFlagBits2::eShaderSampledRead;
+        barrier.oldLayout = vk::ImageLayout::eTransferSrcOptimal;
+        barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+        barrier.subresourceRange.baseMipLevel = level - 1;
+        commandBuffer.pipelineBarrier2(vk::DependencyInfo {
+                .imageMemoryBarrierCount = 1,
+                .pImageMemoryBarriers = &barrier,
+            });
+
+        width = nextWidth;
+        height = nextHeight;
+    }
+
+    barrier.srcStageMask = vk::PipelineStageFlagBits2::eTransfer;
+    barrier.srcAccessMask = vk::AccessFlagBits2::eTransferWrite;
+    barrier.dstStageMask = vk::PipelineStageFlagBits2::eFragmentShader;
+    barrier.dstAccessMask = vk::AccessFlagBits2::eShaderSampledRead;
+    barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+    barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+    barrier.subresourceRange.baseMipLevel = mipLevels - 1;
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo {
+            .imageMemoryBarrierCount = 1,
+            .pImageMemoryBarriers = &barrier,
+        });
+}
 
+bool TextureLoader::supportsMipmapGeneration(const vk::Format format) const
+{
+    const vk::FormatFeatureFlags requiredFeatures = vk::FormatFeatureFlagBits::eBlitSrc
+        | vk::FormatFeatureFlagBits::eBlitDst
+        | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+    return (physicalDevice.getFormatProperties(format).optimalTilingFeatures & requiredFeatures) == requiredFeatures;
+}
+
+eng::Texture TextureLoader::loadTexture(const char* bytes, const vk::DeviceSize size, const vk::Format format, const vk::Extent2D extent)
 {
     auto& [stagingBuffer, stagingBufferAllocation, allocationInfo] = loaderUtility.createStagingBuffer(size);
     std::memcpy(allocationInfo.pMappedData, bytes, size);
 
+    const uint32_t mipLevels = supportsMipmapGeneration(format) ? getMipLevelCount(extent) : 1;
+
     auto [image, allocation] = allocator.createImageUnique(vk::ImageCreateInfo {
             .imageType = vk::ImageType::e2D,
             .format = format,
             .extent = vk::Extent3D{ extent.width, extent.height, 1 },
-            .mipLevels = 1, /* TODO: mip mapping */
+            .mipLevels = mipLevels,
             .arrayLayers = 1,
-            .usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst,
+            .usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc,
             .initialLayout = vk::ImageLayout::eUndefined,
         }, vma::AllocationCreateInfo {
             .usage = vma::MemoryUsage::eAuto,
@@ -60,6 +162,83 @@ eng::Texture TextureLoader::loadTexture(const char* bytes, const vk::DeviceSize
             .imageExtent = vk::Extent3D{ extent.width, extent.height, 1 },
         });
 
+    generateMipmaps(loaderUtility.commandBuffer, *image, extent, mipLevels);
+
+    vk::raii::ImageView imageView(device, vk::ImageViewCreateInfo {
+            .image = *image,
+            .viewType = vk::ImageViewType::e2D,
+            .format = format,
+            .subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, 1 }
+        });
+
+    return { std::move(image), std::move(allocation), std::move(imageView) };
+}
+
+eng::Texture TextureLoader::loadBakedTexture(const BakedTextureView& bakedTexture)
+{
+    const BakedTextureHeader& header = *bakedTexture.header;
+    const vk::Extent2D extent { header.width, header.height };
+
+    if (header.format == BakedTextureFormat::BC1Srgb && !bc1Supported)
+    {
+        std::vector<uint8_t> rgba;
+        decodeBC1(reinterpret_cast<const uint8_t*>(bakedTexture.data + bakedTexture.levels[0].offset), header.width, header.height, rgba);
+        return loadTexture(reinterpret_cast<const char*>(rgba.data()), rgba.size(), vk::Format::eR8G8B8A8Srgb, extent);
+    }
+
+    const vk::Format format = header.format == BakedTextureFormat::BC1Srgb ? vk::Format::eBc1RgbaSrgbBlock : vk::Format::eR8G8B8A8Srgb;
+
+    auto& [stagingBuffer, stagingBufferAllocation, allocationInfo] = loaderUtility.createStagingBuffer(bakedTexture.dataSize);
+    std::memcpy(allocationInfo.pMappedData, bakedTexture.data, bakedTexture.dataSize);
+
+    auto [image, allocation] = allocator.createImageUnique(vk::ImageCreateInfo {
+            .imageType = vk::ImageType::e2D,
+            .format = format,
+            .extent = vk::Extent3D{ extent.width, extent.height, 1 },
+            .mipLevels = header.mipLevels,
+            .arrayLayers = 1,
+            .usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst,
+            .initialLayout = vk::ImageLayout::eUndefined,
+        }, vma::AllocationCreateInfo {
+            .usage = vma::MemoryUsage::eAuto,
+        });
+
+    const vk::ImageSubresourceRange subresourceRange { vk::ImageAspectFlagBits::eColor, 0, header.mipLevels, 0, 1 };
+
+    const vk::ImageMemoryBarrier2 initialImageMemoryBarrier {
+        .srcStageMask = vk::PipelineStageFlagBits2::eTopOfPipe,
+        .srcAccessMask = {},
+        .dstStageMask = vk::PipelineStageFlagBits2::eTransfer,
+        .dstAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        .oldLayout = vk::ImageLayout::eUndefined,
+        .newLayout = vk::ImageLayout::eTransferDstOptimal,
+        .image = *image,
+        .subresourceRange = subresourceRange,
+    };
+
+    loaderUtility.commandBuffer.pipelineBarrier2(vk::DependencyInfo {
+            .imageMemoryBarrierCount = 1,
+            .pImageMemoryBarriers = &initialImageMemoryBarrier,
+        });
+
+    std::vector<vk::BufferImageCopy> regions;
+    regions.reserve(header.mipLevels);
+    for (uint32_t level = 0; level < header.mipLevels; ++level)
+    {
+        regions.push_back(vk::BufferImageCopy {
+                .bufferOffset = bakedTexture.levels[level].offset,
+                .imageSubresource = vk::ImageSubresourceLayers {
+                    .aspectMask = vk::ImageAspectFlagBits::eColor,
+                    .mipLevel = level,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+                .imageExtent = vk::Extent3D{ bakedTexture.levels[level].width, bakedTexture.levels[level].height, 1 },
+            });
+    }
+
+    loaderUtility.commandBuffer.copyBufferToImage(*stagingBuffer, *image, vk::ImageLayout::eTransferDstOptimal, regions);
+
     const vk::ImageMemoryBarrier2 finalImageMemoryBarrier {
         .srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
         .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
@@ -68,13 +247,7 @@ eng::Texture TextureLoader::loadTexture(const char* bytes, const vk::DeviceSize
         .oldLayout = vk::ImageLayout::eTransferDstOptimal,
         .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
         .image = *image,
-        .subresourceRange = vk::ImageSubresourceRange {
-            .aspectMask = vk::ImageAspectFlagBits::eColor,
-            .baseMipLevel = 0,
-            .levelCount= 1,
-            .baseArrayLayer = 0,
-            .layerCount = 1,
-        },
+        .subresourceRange = subresourceRange,
     };
 
     loaderUtility.commandBuffer.pipelineBarrier2(vk::DependencyInfo {
@@ -86,7 +259,7 @@ eng::Texture TextureLoader::loadTexture(const char* bytes, const vk::DeviceSize
             .image = *image,
             .viewType = vk::ImageViewType::e2D,
             .format = format,
-            .subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 }
+            .subresourceRange = subresourceRange,
         });
 
     return { std::move(image), std::move(allocation), std::move(imageView) };
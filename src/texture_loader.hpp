@@ -1,5 +1,6 @@
 #pragma  once
 
+#include "baked_texture.hpp"
 #include "common_definitions.hpp"
 
 namespace eng
@@ -8,12 +9,19 @@ namespace eng
 
     struct TextureLoader
     {
-        explicit TextureLoader(const vk::raii::Device& device, const vma::Allocator& allocator, LoaderUtility& loaderUtility);
+        explicit TextureLoader(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice, const vma::Allocator& allocator, LoaderUtility& loaderUtility);
 
+        // the full mip chain is generated with blits when the format supports linear filtering
         Texture loadTexture(const char* bytes, const vk::DeviceSize size, const vk::Format format, const vk::Extent2D extent);
+        bool supportsMipmapGeneration(const vk::Format format) const;
+
+        // uploads every level as stored; BC1 data is decoded on the CPU if the device can't sample it
+        Texture loadBakedTexture(const BakedTextureView& bakedTexture);
 
         const vk::raii::Device& device;
+        const vk::raii::PhysicalDevice& physicalDevice;
         const vma::Allocator& allocator;
         LoaderUtility& loaderUtility;
+        const bool bc1Supported;
     };
 }
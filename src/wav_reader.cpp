@@ -0,0 +1,152 @@
+#include "wav_reader.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using eng::WavInfo;
+
+namespace
+{
+    struct ChunkHeader
+    {
+        char id[4];
+        uint32_t size;
+    };
+
+    bool readExact(SDL_IOStream* io, void* data, const size_t size)
+    {
+        return SDL_ReadIO(io, data, size) == size;
+    }
+
+    uint16_t readU16(const uint8_t* bytes)
+    {
+        return bytes[0] | (bytes[1] << 8);
+    }
+
+    uint32_t readU32(const uint8_t* bytes)
+    {
+        return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+    }
+
+    SDL_AudioFormat getAudioFormat(const uint16_t formatTag, const uint16_t bitsPerSample)
+    {
+        constexpr uint16_t FORMAT_PCM = 1;
+        constexpr uint16_t FORMAT_IEEE_FLOAT = 3;
+        if (formatTag == FORMAT_PCM)
+        {
+            switch (bitsPerSample)
+            {
+                case 8: return SDL_AUDIO_U8;
+                case 16: return SDL_AUDIO_S16LE;
+                case 32: return SDL_AUDIO_S32LE;
+                default: break;
+            }
+        }
+        else if (formatTag == FORMAT_IEEE_FLOAT && bitsPerSample == 32)
+        {
+            return SDL_AUDIO_F32LE;
+        }
+        throw std::runtime_error("Unsupported WAV sample format");
+    }
+}
+
+WavInfo eng::readWavInfo(SDL_IOStream* io)
+{
+    uint8_t riff[12];
+    if (!readExact(io, riff, sizeof(riff)) || std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0)
+    {
+        throw std::runtime_error("Not a RIFF WAVE file");
+    }
+
+    WavInfo info {};
+    bool hasFormat = false;
+    bool hasData = false;
+    bool hasLoop = false;
+
+    ChunkHeader chunk;
+    while (readExact(io, &chunk, sizeof(chunk)))
+    {
+        const int64_t chunkStart = SDL_TellIO(io);
+        // chunks are padded to an even size
+        const int64_t nextChunk = chunkStart + chunk.size + (chunk.size & 1);
+
+        if (std::memcmp(chunk.id, "fmt ", 4) == 0)
+        {
+            uint8_t format[40] = {};
+            if (chunk.size < 16 || !readExact(io, format, std::min<uint32_t>(chunk.size, sizeof(format))))
+            {
+                throw std::runtime_error("WAV format chunk is truncated");
+            }
+
+            uint16_t formatTag = readU16(format);
+            constexpr uint16_t FORMAT_EXTENSIBLE = 0xfffe;
+            if (formatTag == FORMAT_EXTENSIBLE && chunk.size >= 26)
+            {
+                // the sub-format GUID starts with the real format tag
+                formatTag = readU16(format + 24);
+            }
+
+            const uint16_t channels = readU16(format + 2);
+            const uint16_t blockAlign = readU16(format + 12);
+            const uint16_t bitsPerSample = readU16(format + 14);
+            if (channels == 0 || blockAlign == 0)
+            {
+                throw std::runtime_error("WAV format chunk is invalid");
+            }
+
+            info.spec = SDL_AudioSpec {
+                .format = getAudioFormat(formatTag, bitsPerSample),
+                .channels = channels,
+                .freq = static_cast<int>(readU32(format + 4)),
+            };
+            info.frameSize = blockAlign;
+            hasFormat = true;
+        }
+        else if (std::memcmp(chunk.id, "data", 4) == 0)
+        {
+            info.dataOffset = chunkStart;
+            info.dataSize = chunk.size;
+            hasData = true;
+        }
+        else if (std::memcmp(chunk.id, "smpl", 4) == 0 && chunk.size >= 60)
+        {
+            uint8_t sampler[60];
+            if (!readExact(io, sampler, sizeof(sampler)))
+            {
+                throw std::runtime_error("WAV sampler chunk is truncated");
+            }
+            // 36 byte header, the first loop record follows; loop end is the last frame played, inclusive
+            if (readU32(sampler + 28) > 0)
+            {
+                info.loopStart = readU32(sampler + 44);
+                info.loopEnd = static_cast<uint64_t>(readU32(sampler + 48)) + 1;
+                hasLoop = true;
+            }
+        }
+
+        if (SDL_SeekIO(io, nextChunk, SDL_IO_SEEK_SET) < 0)
+        {
+            break;
+        }
+    }
+
+    if (!hasFormat || !hasData)
+    {
+        throw std::runtime_error("WAV file is missing its format or data chunk");
+    }
+
+    const uint64_t frameCount = info.dataSize / info.frameSize;
+    info.dataSize = frameCount * info.frameSize;
+    if (hasLoop && info.loopStart < info.loopEnd && info.loopEnd <= frameCount)
+    {
+        info.loopStart *= info.frameSize;
+        info.loopEnd *= info.frameSize;
+    }
+    else
+    {
+        info.loopStart = 0;
+        info.loopEnd = info.dataSize;
+    }
+
+    return info;
+}
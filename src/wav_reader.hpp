@@ -0,0 +1,24 @@
+#pragma once
+
+#include <SDL3/SDL_audio.h>
+#include <SDL3/SDL_iostream.h>
+#include <cstdint>
+
+namespace eng
+{
+    // Layout of the sample data in a RIFF WAVE file. Loop points come from the first loop of a "smpl" chunk,
+    // or cover the whole data chunk if there is none. Offsets are in bytes from the start of the data.
+    struct WavInfo
+    {
+        SDL_AudioSpec spec;
+        uint32_t frameSize;
+        uint64_t dataOffset;
+        uint64_t dataSize;
+        uint64_t loopStart;
+        uint64_t loopEnd;
+    };
+
+    // walks the chunk list, skipping JUNK, LIST and anything else unknown, throws std::runtime_error if the
+    // file is malformed or the sample format isn't supported
+    WavInfo readWavInfo(SDL_IOStream* io);
+}